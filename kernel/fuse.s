@@ -0,0 +1,174 @@
+	.file	"fuse.s"
+	.option nopic
+	.attribute arch, "rv32i2p0"
+	.attribute unaligned_access, 0
+	.attribute stack_align, 16
+	.text
+	.section	.rodata.str1.4,"aMS",@progbits,1
+	.align	2
+.LC0:
+	.string	"Bench name: Fusion and move elimination"
+	.section	.rodata
+	.align	2
+# slli+add operands: a, b.
+.LC1:
+	.word	0x00000001, 0x00000000
+	.word	0x00000003, 0x00000005
+	.word	0x80000001, 0xffffffff
+	.word	0x12345678, 0x00000005
+	.word	0xffffffff, 0x80000000
+
+# Each check computes a value with the fused pair and again with the pair
+# split by a nop, and aborts if they differ.
+
+# lui+addi
+	.macro	check_lui v
+	lui a0, %hi(\v)
+	addi a0, a0, %lo(\v)
+	lui a1, %hi(\v)
+	nop
+	addi a1, a1, %lo(\v)
+	bne a0, a1, fail
+	.endm
+
+# auipc+addi, as an offset from an auipc two instructions before.
+	.macro	check_auipc hi, lo
+	auipc t0, 0
+	nop
+	auipc t1, \hi
+	addi t1, t1, \lo
+	sub t1, t1, t0
+	lui t2, %hi((\hi << 12) + \lo + 8)
+	nop
+	addi t2, t2, %lo((\hi << 12) + \lo + 8)
+	bne t1, t2, fail
+	.endm
+
+# slli+add with the shifted value as either source of the add.
+	.macro	check_shadd sh
+	slli a2, a0, \sh
+	add a2, a2, a1
+	slli a3, a0, \sh
+	add a3, a1, a3
+	slli a4, a0, \sh
+	nop
+	add a4, a4, a1
+	bne a2, a4, fail
+	bne a3, a4, fail
+	.endm
+
+	.text
+	.align	2
+	.globl	main
+	.type	main, @function
+main:
+# Print name
+	lui	a5,%hi(.LC0)
+	addi	a5,a5,%lo(.LC0)
+	addi t3, zero, 4
+	addi t4, a5, 0
+	ebreak
+# Bench start
+	addi t3, zero, 5
+	ebreak
+
+	li s0, 0
+	li s1, 0
+	li s2, 0
+	li s3, 256
+outer:
+	check_lui 0
+	check_lui 1
+	check_lui 0x7ff
+	check_lui 0x800
+	check_lui 0xfff
+	check_lui 0x12345678
+	check_lui 0xfffff800
+	check_lui 0x80000000
+	check_lui 0xffffffff
+	check_lui 0x7ffff7ff
+
+	check_auipc 0, 0
+	check_auipc 0, 4
+	check_auipc 0, -4
+	check_auipc 0, 2047
+	check_auipc 0, -2048
+	check_auipc 3, 0
+	check_auipc 3, 2047
+	check_auipc 3, -2048
+
+	lui a6,%hi(.LC1)
+	addi a6,a6,%lo(.LC1)
+	addi a7, a6, 40
+shadd:
+	lw a0, 0(a6)
+	lw a1, 4(a6)
+	check_shadd 0
+	check_shadd 1
+	check_shadd 3
+	check_shadd 31
+	addi a6, a6, 8
+	bne a6, a7, shadd
+
+# Not fused: the add reads the shifted value twice, (3 << 2) * 2.
+	li a0, 3
+	slli a2, a0, 2
+	add a2, a2, a2
+	li a3, 24
+	bne a2, a3, fail
+
+# A move keeps the old value when its source is written again.
+	li a0, 7
+	addi a2, a0, 0
+	addi a0, a0, 1
+	addi a3, a2, 1
+	bne a0, a3, fail
+# Zero idioms.
+	xor a4, a0, a0
+	bnez a4, fail
+	sub a4, a0, a0
+	bnez a4, fail
+# Constants, and a constant 0.
+	addi a5, zero, -5
+	addi a5, a5, 5
+	bnez a5, fail
+	addi a5, zero, 0
+	bnez a5, fail
+
+# auipc+jalr calls, one with an odd offset that jalr rounds down.
+	auipc ra, 0
+	jalr ra, 16(ra)
+	addi s1, s1, 1
+	j 1f
+	addi s0, s0, 1
+	jalr zero, 0(ra)
+1:
+	auipc ra, 0
+	jalr ra, 17(ra)
+	addi s1, s1, 1
+	j 1f
+	addi s0, s0, 1
+	jalr zero, 0(ra)
+1:
+	bne s0, s1, fail
+
+	addi s2, s2, 1
+	blt s2, s3, outer
+
+# End bench
+	addi t3, zero, 6
+	ebreak
+# Quit
+	addi t3, zero, 2
+	ebreak
+
+	ret
+
+fail:
+# Assertion failed
+	addi t3, zero, 3
+	ebreak
+	addi t3, zero, 2
+	ebreak
+
+	ret
@@ -0,0 +1,75 @@
+	.file	"load_order.s"
+	.option nopic
+	.attribute arch, "rv32i2p0"
+	.attribute unaligned_access, 0
+	.attribute stack_align, 16
+	.text
+	.section	.rodata.str1.4,"aMS",@progbits,1
+	.align	2
+.LC0:
+	.string	"Bench name: Loads behind a slow address"
+	.text
+	.align	2
+	.globl	main
+	.type	main, @function
+main:
+# Print name
+	lui	a5,%hi(.LC0)
+	addi	a5,a5,%lo(.LC0)
+	addi t3, zero, 4
+	addi t4, a5, 0
+	ebreak
+
+# Random mem in heap.
+	addi a0, tp, 0
+	li s1, 1024
+	li t1, 5
+	sw t1, 0(a0)
+	sw t1, 4(a0)
+	addi t1, s1, 1
+	sw t1, 8(a0)
+
+# Bench start
+	addi t3, zero, 5
+	ebreak
+
+loop_start:
+	lw a1, 0(a0)		# a1 <- 5
+	add a1, a1, a0
+	addi a1, a1, -5		# a1 = a0, but only once the load is back
+	lw a2, 0(a1)		# waits for the address
+	lw a3, 4(a0)		# these can go first
+	lw a4, 4(a0)
+	lw a5, 0(a0)		# same word as a2, read before it
+	lw a6, 8(a1)		# last iteration's store
+	sw s1, 8(a0)
+	lw a7, 8(a0)		# the store in between changes what this sees
+	add t2, a3, a4
+	add t2, t2, a5
+	bne a2, a5, fail
+	addi t1, s1, 1
+	bne a6, t1, fail
+	bne a7, s1, fail
+	addi s1, s1, -1
+	bnez s1, loop_start
+
+	li t1, 15
+	bne t2, t1, fail
+
+# End bench
+	addi t3, zero, 6
+	ebreak
+# Quit
+	addi t3, zero, 2
+	ebreak
+
+	ret
+
+fail:
+# Assertion failed
+	addi t3, zero, 3
+	ebreak
+	addi t3, zero, 2
+	ebreak
+
+	ret
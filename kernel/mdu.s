@@ -0,0 +1,183 @@
+	.file	"mdu.s"
+	.option nopic
+	.attribute arch, "rv32i2p0_m2p0"
+	.attribute unaligned_access, 0
+	.attribute stack_align, 16
+	.text
+	.section	.rodata.str1.4,"aMS",@progbits,1
+	.align	2
+.LC0:
+	.string	"Bench name: Multiply and divide"
+	.section	.rodata
+	.align	2
+# Each row: a, b, then a op b for mul, mulh, mulhsu, mulhu, div, divu,
+# rem, remu, including division by zero and the signed overflow case.
+.LC1:
+	.word	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000
+	.word	0x00000000, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000000, 0x00bc614e, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+	.word	0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000001, 0x00000001
+	.word	0x00000001, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0x00000001, 0x00000007, 0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001
+	.word	0x00000001, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001
+	.word	0x00000001, 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0xffffffff, 0x00000000, 0x00000000, 0x00000001
+	.word	0x00000001, 0x80000000, 0x80000000, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001
+	.word	0x00000001, 0x7fffffff, 0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001
+	.word	0x00000001, 0x00bc614e, 0x00bc614e, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001
+	.word	0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000007, 0x00000007
+	.word	0x00000007, 0x00000001, 0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000007, 0x00000007, 0x00000000, 0x00000000
+	.word	0x00000007, 0x00000007, 0x00000031, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0x00000007, 0x00000003, 0x00000015, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002, 0x00000001, 0x00000001
+	.word	0x00000007, 0xffffffff, 0xfffffff9, 0xffffffff, 0x00000006, 0x00000006, 0xfffffff9, 0x00000000, 0x00000000, 0x00000007
+	.word	0x00000007, 0x80000000, 0x80000000, 0xfffffffc, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000007, 0x00000007
+	.word	0x00000007, 0x7fffffff, 0x7ffffff9, 0x00000003, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000007, 0x00000007
+	.word	0x00000007, 0x00bc614e, 0x0526a922, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000007, 0x00000007
+	.word	0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000003, 0x00000003
+	.word	0x00000003, 0x00000001, 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003, 0x00000000, 0x00000000
+	.word	0x00000003, 0x00000007, 0x00000015, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003
+	.word	0x00000003, 0x00000003, 0x00000009, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0x00000003, 0xffffffff, 0xfffffffd, 0xffffffff, 0x00000002, 0x00000002, 0xfffffffd, 0x00000000, 0x00000000, 0x00000003
+	.word	0x00000003, 0x80000000, 0x80000000, 0xfffffffe, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000003, 0x00000003
+	.word	0x00000003, 0x7fffffff, 0x7ffffffd, 0x00000001, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000003, 0x00000003
+	.word	0x00000003, 0x00bc614e, 0x023523ea, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003
+	.word	0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+	.word	0xffffffff, 0x00000001, 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000
+	.word	0xffffffff, 0x00000007, 0xfffffff9, 0xffffffff, 0xffffffff, 0x00000006, 0x00000000, 0x24924924, 0xffffffff, 0x00000003
+	.word	0xffffffff, 0x00000003, 0xfffffffd, 0xffffffff, 0xffffffff, 0x00000002, 0x00000000, 0x55555555, 0xffffffff, 0x00000000
+	.word	0xffffffff, 0xffffffff, 0x00000001, 0x00000000, 0xffffffff, 0xfffffffe, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0xffffffff, 0x80000000, 0x80000000, 0x00000000, 0xffffffff, 0x7fffffff, 0x00000000, 0x00000001, 0xffffffff, 0x7fffffff
+	.word	0xffffffff, 0x7fffffff, 0x80000001, 0xffffffff, 0xffffffff, 0x7ffffffe, 0x00000000, 0x00000002, 0xffffffff, 0x00000001
+	.word	0xffffffff, 0x00bc614e, 0xff439eb2, 0xffffffff, 0xffffffff, 0x00bc614d, 0x00000000, 0x0000015b, 0xffffffff, 0x00a81b45
+	.word	0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x80000000, 0x80000000
+	.word	0x80000000, 0x00000001, 0x80000000, 0xffffffff, 0xffffffff, 0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000
+	.word	0x80000000, 0x00000007, 0x80000000, 0xfffffffc, 0xfffffffc, 0x00000003, 0xedb6db6e, 0x12492492, 0xfffffffe, 0x00000002
+	.word	0x80000000, 0x00000003, 0x80000000, 0xfffffffe, 0xfffffffe, 0x00000001, 0xd5555556, 0x2aaaaaaa, 0xfffffffe, 0x00000002
+	.word	0x80000000, 0xffffffff, 0x80000000, 0x00000000, 0x80000000, 0x7fffffff, 0x80000000, 0x00000000, 0x00000000, 0x80000000
+	.word	0x80000000, 0x80000000, 0x00000000, 0x40000000, 0xc0000000, 0x40000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0x80000000, 0x7fffffff, 0x80000000, 0xc0000000, 0xc0000000, 0x3fffffff, 0xffffffff, 0x00000001, 0xffffffff, 0x00000001
+	.word	0x80000000, 0x00bc614e, 0x00000000, 0xffa1cf59, 0xffa1cf59, 0x005e30a7, 0xffffff53, 0x000000ad, 0xff4dc1b6, 0x00b23e4a
+	.word	0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x7fffffff, 0x7fffffff
+	.word	0x7fffffff, 0x00000001, 0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x7fffffff, 0x7fffffff, 0x00000000, 0x00000000
+	.word	0x7fffffff, 0x00000007, 0x7ffffff9, 0x00000003, 0x00000003, 0x00000003, 0x12492492, 0x12492492, 0x00000001, 0x00000001
+	.word	0x7fffffff, 0x00000003, 0x7ffffffd, 0x00000001, 0x00000001, 0x00000001, 0x2aaaaaaa, 0x2aaaaaaa, 0x00000001, 0x00000001
+	.word	0x7fffffff, 0xffffffff, 0x80000001, 0xffffffff, 0x7ffffffe, 0x7ffffffe, 0x80000001, 0x00000000, 0x00000000, 0x7fffffff
+	.word	0x7fffffff, 0x80000000, 0x80000000, 0xc0000000, 0x3fffffff, 0x3fffffff, 0x00000000, 0x00000000, 0x7fffffff, 0x7fffffff
+	.word	0x7fffffff, 0x7fffffff, 0x00000001, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0x7fffffff, 0x00bc614e, 0xff439eb2, 0x005e30a6, 0x005e30a6, 0x005e30a6, 0x000000ad, 0x000000ad, 0x00b23e49, 0x00b23e49
+	.word	0x00bc614e, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00bc614e, 0x00bc614e
+	.word	0x00bc614e, 0x00000001, 0x00bc614e, 0x00000000, 0x00000000, 0x00000000, 0x00bc614e, 0x00bc614e, 0x00000000, 0x00000000
+	.word	0x00bc614e, 0x00000007, 0x0526a922, 0x00000000, 0x00000000, 0x00000000, 0x001ae954, 0x001ae954, 0x00000002, 0x00000002
+	.word	0x00bc614e, 0x00000003, 0x023523ea, 0x00000000, 0x00000000, 0x00000000, 0x003ecb1a, 0x003ecb1a, 0x00000000, 0x00000000
+	.word	0x00bc614e, 0xffffffff, 0xff439eb2, 0xffffffff, 0x00bc614d, 0x00bc614d, 0xff439eb2, 0x00000000, 0x00000000, 0x00bc614e
+	.word	0x00bc614e, 0x80000000, 0x00000000, 0xffa1cf59, 0x005e30a7, 0x005e30a7, 0x00000000, 0x00000000, 0x00bc614e, 0x00bc614e
+	.word	0x00bc614e, 0x7fffffff, 0xff439eb2, 0x005e30a6, 0x005e30a6, 0x005e30a6, 0x00000000, 0x00000000, 0x00bc614e, 0x00bc614e
+	.word	0x00bc614e, 0x00bc614e, 0x0f8c33c4, 0x00008a9f, 0x00008a9f, 0x00008a9f, 0x00000001, 0x00000001, 0x00000000, 0x00000000
+	.word	0xfedcba98, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xfedcba98, 0xfedcba98
+	.word	0xfedcba98, 0x00000001, 0xfedcba98, 0xffffffff, 0xffffffff, 0x00000000, 0xfedcba98, 0xfedcba98, 0x00000000, 0x00000000
+	.word	0xfedcba98, 0x00000007, 0xf8091a28, 0xffffffff, 0xffffffff, 0x00000006, 0xffd663cd, 0x2468acf1, 0xfffffffd, 0x00000001
+	.word	0xfedcba98, 0x00000003, 0xfc962fc8, 0xffffffff, 0xffffffff, 0x00000002, 0xff9ee8de, 0x54f43e32, 0xfffffffe, 0x00000002
+	.word	0xfedcba98, 0xffffffff, 0x01234568, 0x00000000, 0xfedcba98, 0xfedcba97, 0x01234568, 0x00000000, 0x00000000, 0xfedcba98
+	.word	0xfedcba98, 0x80000000, 0x00000000, 0x0091a2b4, 0xff6e5d4c, 0x7f6e5d4c, 0x00000000, 0x00000001, 0xfedcba98, 0x7edcba98
+	.word	0xfedcba98, 0x7fffffff, 0x01234568, 0xff6e5d4c, 0xff6e5d4c, 0x7f6e5d4b, 0x00000000, 0x00000001, 0xfedcba98, 0x7edcba99
+	.word	0xfedcba98, 0x00bc614e, 0x51947250, 0xffff29aa, 0xffff29aa, 0x00bb8af8, 0xffffffff, 0x0000015a, 0xff991be6, 0x0041372c
+	.word	0x00000064, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000064, 0x00000064
+	.word	0x00000064, 0x00000001, 0x00000064, 0x00000000, 0x00000000, 0x00000000, 0x00000064, 0x00000064, 0x00000000, 0x00000000
+	.word	0x00000064, 0x00000007, 0x000002bc, 0x00000000, 0x00000000, 0x00000000, 0x0000000e, 0x0000000e, 0x00000002, 0x00000002
+	.word	0x00000064, 0x00000003, 0x0000012c, 0x00000000, 0x00000000, 0x00000000, 0x00000021, 0x00000021, 0x00000001, 0x00000001
+	.word	0x00000064, 0xffffffff, 0xffffff9c, 0xffffffff, 0x00000063, 0x00000063, 0xffffff9c, 0x00000000, 0x00000000, 0x00000064
+	.word	0x00000064, 0x80000000, 0x00000000, 0xffffffce, 0x00000032, 0x00000032, 0x00000000, 0x00000000, 0x00000064, 0x00000064
+	.word	0x00000064, 0x7fffffff, 0xffffff9c, 0x00000031, 0x00000031, 0x00000031, 0x00000000, 0x00000000, 0x00000064, 0x00000064
+	.word	0x00000064, 0x00bc614e, 0x49960278, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000064, 0x00000064
+	.word	0xfffffff9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xfffffff9, 0xfffffff9
+	.word	0xfffffff9, 0x00000001, 0xfffffff9, 0xffffffff, 0xffffffff, 0x00000000, 0xfffffff9, 0xfffffff9, 0x00000000, 0x00000000
+	.word	0xfffffff9, 0x00000007, 0xffffffcf, 0xffffffff, 0xffffffff, 0x00000006, 0xffffffff, 0x24924923, 0x00000000, 0x00000004
+	.word	0xfffffff9, 0x00000003, 0xffffffeb, 0xffffffff, 0xffffffff, 0x00000002, 0xfffffffe, 0x55555553, 0xffffffff, 0x00000000
+	.word	0xfffffff9, 0xffffffff, 0x00000007, 0x00000000, 0xfffffff9, 0xfffffff8, 0x00000007, 0x00000000, 0x00000000, 0xfffffff9
+	.word	0xfffffff9, 0x80000000, 0x80000000, 0x00000003, 0xfffffffc, 0x7ffffffc, 0x00000000, 0x00000001, 0xfffffff9, 0x7ffffff9
+	.word	0xfffffff9, 0x7fffffff, 0x80000007, 0xfffffffc, 0xfffffffc, 0x7ffffffb, 0x00000000, 0x00000001, 0xfffffff9, 0x7ffffffa
+	.word	0xfffffff9, 0x00bc614e, 0xfad956de, 0xffffffff, 0xffffffff, 0x00bc614d, 0x00000000, 0x0000015b, 0xfffffff9, 0x00a81b3f
+	.text
+	.align	2
+	.globl	main
+	.type	main, @function
+main:
+# Print name
+	lui	a5,%hi(.LC0)
+	addi	a5,a5,%lo(.LC0)
+	addi t3, zero, 4
+	addi t4, a5, 0
+	ebreak
+# Bench start
+	addi t3, zero, 5
+	ebreak
+
+# Check all eight ops on each row: 704 results.
+	lui	s0,%hi(.LC1)
+	addi	s0,s0,%lo(.LC1)
+	li s1, 88
+check:
+	lw a0, 0(s0)
+	lw a1, 4(s0)
+	mul a2, a0, a1
+	lw a3, 8(s0)
+	bne a2, a3, fail
+	mulh a2, a0, a1
+	lw a3, 12(s0)
+	bne a2, a3, fail
+	mulhsu a2, a0, a1
+	lw a3, 16(s0)
+	bne a2, a3, fail
+	mulhu a2, a0, a1
+	lw a3, 20(s0)
+	bne a2, a3, fail
+	div a2, a0, a1
+	lw a3, 24(s0)
+	bne a2, a3, fail
+	divu a2, a0, a1
+	lw a3, 28(s0)
+	bne a2, a3, fail
+	rem a2, a0, a1
+	lw a3, 32(s0)
+	bne a2, a3, fail
+	remu a2, a0, a1
+	lw a3, 36(s0)
+	bne a2, a3, fail
+	addi s0, s0, 40
+	addi s1, s1, -1
+	bnez s1, check
+
+# Dependent chains through the multiplier and the divider.
+	li s0, 0
+	li s1, 4096
+	li a0, 3
+	li a4, 1
+loop_start:
+	mul a4, a4, a0
+	mul a4, a4, a0
+	divu a5, s1, a0
+	add a5, a5, a4
+	addi s0, s0, 1
+	blt s0, s1, loop_start
+
+# End bench
+	addi t3, zero, 6
+	ebreak
+# Quit
+	addi t3, zero, 2
+	ebreak
+
+	ret
+
+fail:
+# Assertion failed
+	addi t3, zero, 3
+	ebreak
+	addi t3, zero, 2
+	ebreak
+
+	ret
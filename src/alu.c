@@ -62,6 +62,28 @@ enum alu_op instr_alu_op(word_u instr)
 	}
 }
 
+enum fu_class alu_op_class(enum alu_op op)
+{
+	switch (op) {
+	case ALU_OP_ADD:
+	case ALU_OP_SUB:
+	case ALU_OP_SLT:
+	case ALU_OP_SLTU:
+	case ALU_OP_SHADD:
+		return FU_ADD;
+	case ALU_OP_XOR:
+	case ALU_OP_OR:
+	case ALU_OP_AND:
+		return FU_LOGIC;
+	case ALU_OP_SLL:
+	case ALU_OP_SRL:
+	case ALU_OP_SRA:
+		return FU_SHIFT;
+	default:
+		assert(0);
+	}
+}
+
 word_u alu_result(const alu_t *alu)
 {
 	switch (alu->op) {
@@ -95,6 +117,9 @@ word_u alu_result(const alu_t *alu)
 	case ALU_OP_SRA:
 		tracei("[ex] ALU: %d >> %u (arithmetic)\n", alu->op1.s, alu->op2.u);
 		return (word_u) { .s = alu->op1.s >> (alu->op2.u & 0x1F) };
+	case ALU_OP_SHADD:
+		tracei("[ex] ALU: (%u << %u) + %u\n", alu->op1.u, alu->shamt, alu->op2.u);
+		return (word_u) { .u = (alu->op1.u << alu->shamt) + alu->op2.u };
 	default:
 		assert(0);
 	}
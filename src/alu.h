@@ -1,5 +1,7 @@
 #pragma once
 
+#include "fu.h"
+#include "prf.h"
 #include "word.h"
 
 /* ALU - Addition, etc. */
@@ -17,6 +19,8 @@ enum alu_op {
 	ALU_OP_SLL	= 0x101,
 	ALU_OP_SRL	= 0x105,
 	ALU_OP_SRA	= 0x115,
+	/* Fused slli+add: (op1 << shamt) + op2. */
+	ALU_OP_SHADD	= 0x120,
 
 	ALU_OP_SET = 0x100,
 };
@@ -25,11 +29,16 @@ typedef struct {
 	enum alu_op op;
 	word_u op1, op2;
 	size_t rob_id;
+	preg_t dest;
+	uint8_t shamt;
 	size_t clk_start;
 } alu_t;
 
 enum alu_op instr_alu_op(word_u instr);
 
+/* Timing class, see fu_timing. */
+enum fu_class alu_op_class(enum alu_op op);
+
 /* Return the result of an ALU operation. */
 word_u alu_result(const alu_t *alu);
 
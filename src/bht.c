@@ -1,5 +1,7 @@
 #include "bht.h"
 
+#include <stdlib.h>
+
 #include "util.h"
 
 size_t bht_index(word_u pc, size_t global_history)
@@ -14,12 +16,13 @@ size_t bht_index(word_u pc, size_t global_history)
 	}
 }
 
-uint8_t bht_update(const struct bht *curr, struct bht *next, word_u pc, size_t global_history, bool taken)
+uint8_t bht_update(struct bht *bht, word_u pc, size_t global_history, bool taken)
 {
 	size_t index = bht_index(pc, global_history);
 
-	const bht_entry_t *old = &curr->buffer[index];
-	bht_entry_t *e = &next->buffer[index];
+	const bht_entry_t old_entry = bht->buffer[index];
+	const bht_entry_t *old = &old_entry;
+	bht_entry_t *e = &bht->buffer[index];
 
 	if (old->valid) {
 		assert(old->debug_last_pc.u);
@@ -51,3 +54,35 @@ uint8_t bht_update(const struct bht *curr, struct bht *next, word_u pc, size_t g
 	return e->ctr;
 }
 
+static void *bht_create(void)
+{
+	return calloc(1, sizeof(struct bht));
+}
+
+static void bht_clear(void *self)
+{
+	*(struct bht *)self = (struct bht){ 0 };
+}
+
+static enum bpred_dir bht_predict(const void *self, const struct bpred_hist *hist, word_u pc)
+{
+	const struct bht *bht = self;
+	const bht_entry_t *e = &bht->buffer[bht_index(pc, hist->recent)];
+	if (!e->valid)
+		return BPRED_NONE;
+	return e->ctr > 1 ? BPRED_TAKEN : BPRED_NOT_TAKEN;
+}
+
+static bool bht_resolve(void *self, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats)
+{
+	return bht_update(self, pc, hist->recent, taken) > 1;
+}
+
+const struct bpred_ops bht_ops = {
+	.name = "bht",
+	.create = bht_create,
+	.clear = bht_clear,
+	.predict = bht_predict,
+	.spec_update = bpred_hist_shift,
+	.resolve = bht_resolve,
+};
@@ -3,6 +3,7 @@
 
 #include "word.h"
 #include "config.h"
+#include "bpred.h"
 
 typedef struct {
 	bool valid;
@@ -18,5 +19,6 @@ struct bht {
 /* Mapping pc * history -> bht_index. */
 size_t bht_index(word_u pc, size_t global_history);
 
-uint8_t bht_update(const struct bht *curr, struct bht *next, word_u pc, size_t global_history, bool taken);
+uint8_t bht_update(struct bht *bht, word_u pc, size_t global_history, bool taken);
 
+extern const struct bpred_ops bht_ops;
@@ -0,0 +1,124 @@
+#include "bhtsweep.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+struct bht_sweep *bht_sweep_create(void)
+{
+	/* History lengths 1.. in both index schemes, plus no history. Longer
+	 * gshare histories than index bits fold onto the same entries, so
+	 * they are left out. */
+	size_t count = 0;
+	for (size_t ib = BHT_SWEEP_MIN_INDEX_BITS; ib <= BHT_SWEEP_MAX_INDEX_BITS; ib++)
+		for (size_t hb = 0; hb <= BHT_SWEEP_MAX_HIST_BITS; hb++)
+			count += 1 + (hb && hb <= ib);
+
+	struct bht_sweep *sw = calloc(1, sizeof(*sw));
+	assert(sw);
+	sw->index_bits = calloc(count, sizeof(*sw->index_bits));
+	sw->hist_bits = calloc(count, sizeof(*sw->hist_bits));
+	sw->gshare = calloc(count, sizeof(*sw->gshare));
+	sw->base = calloc(count, sizeof(*sw->base));
+	sw->miss = calloc(count, sizeof(*sw->miss));
+	assert(sw->index_bits && sw->hist_bits && sw->gshare && sw->base && sw->miss);
+
+	for (size_t ib = BHT_SWEEP_MIN_INDEX_BITS; ib <= BHT_SWEEP_MAX_INDEX_BITS; ib++) {
+		for (size_t hb = 0; hb <= BHT_SWEEP_MAX_HIST_BITS; hb++) {
+			for (int gs = 0; gs <= (hb && hb <= ib); gs++) {
+				const size_t i = sw->count++;
+				sw->index_bits[i] = ib;
+				sw->hist_bits[i] = hb;
+				sw->gshare[i] = gs;
+				sw->base[i] = sw->ctrs_size;
+				sw->ctrs_size += (size_t)1 << ib;
+			}
+		}
+	}
+	assert(sw->count == count);
+	sw->ctrs = calloc(sw->ctrs_size, 1);
+	assert(sw->ctrs);
+	return sw;
+}
+
+void bht_sweep_destroy(struct bht_sweep *sw)
+{
+	if (!sw)
+		return;
+	free(sw->index_bits);
+	free(sw->hist_bits);
+	free(sw->gshare);
+	free(sw->base);
+	free(sw->miss);
+	free(sw->ctrs);
+	free(sw);
+}
+
+void bht_sweep_clear(struct bht_sweep *sw)
+{
+	memset(sw->miss, 0, sw->count * sizeof(*sw->miss));
+	memset(sw->ctrs, 0, sw->ctrs_size);
+	sw->history = 0;
+	sw->branches = 0;
+}
+
+void bht_sweep_update(struct bht_sweep *sw, word_u pc, bool backward, bool taken)
+{
+	const size_t pc4 = pc.u / 4u;
+	const size_t history = sw->history;
+
+	/* Same indexing and counters as bht_index and bht_update. */
+	for (size_t i = 0; i < sw->count; i++) {
+		const size_t hb = sw->hist_bits[i];
+		const size_t h = history & (((size_t)1 << hb) - 1);
+		const size_t idx = (sw->gshare[i] ? pc4 ^ h : (pc4 << hb) | h)
+			& (((size_t)1 << sw->index_bits[i]) - 1);
+		uint8_t *c = &sw->ctrs[sw->base[i] + idx];
+
+		const uint8_t old = *c;
+		/* Invalid entries fall back to backwards taken, like decode. */
+		const bool pred = old ? old > 2 : backward;
+		sw->miss[i] += pred != taken;
+
+		if (!old)
+			*c = taken ? 3 : 2;
+		else if (taken && old != 4)
+			*c = old + 1;
+		else if (!taken && old != 1)
+			*c = old - 1;
+	}
+
+	sw->history = (history << 1) | taken;
+	sw->branches++;
+}
+
+void bht_sweep_print(const struct bht_sweep *sw, size_t insts)
+{
+	if (!sw->branches)
+		return;
+
+	printf("BHT sweep: %lu branches in %lu instructions\n", sw->branches, insts);
+	printf("Entries\tHistory\tIndex\tMispredicts\tAccuracy\tMPKI\n");
+	size_t best = 0;
+	for (size_t i = 0; i < sw->count; i++) {
+		printf("%lu\t%u\t%s\t%lu\t\t%.2f%%\t\t%.3f\n",
+			(size_t)1 << sw->index_bits[i], sw->hist_bits[i],
+			sw->gshare[i] ? "gshare" : "concat", sw->miss[i],
+			100. * (double)(sw->branches - sw->miss[i]) / (double)sw->branches,
+			1000. * (double)sw->miss[i] / (double)insts);
+
+		/* Best configuration for each table size. */
+		if (sw->miss[i] < sw->miss[best])
+			best = i;
+		if (i + 1 == sw->count || sw->index_bits[i + 1] != sw->index_bits[i]) {
+			printf("Best for %lu entries: %u history bits, %s, %.3f MPKI\n",
+				(size_t)1 << sw->index_bits[best], sw->hist_bits[best],
+				sw->gshare[best] ? "gshare" : "concat",
+				1000. * (double)sw->miss[best] / (double)insts);
+			best = i + 1;
+		}
+	}
+}
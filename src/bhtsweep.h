@@ -0,0 +1,39 @@
+/* BHT design space sweep.
+ * Many BHT configurations trained side by side on the retired branch
+ * stream of one run, each keeping its own mispredict count. */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "word.h"
+
+/* One entry per configuration in each array, so a single loop walks them
+ * all for every branch. */
+struct bht_sweep {
+	size_t count;
+	uint8_t *index_bits;
+	uint8_t *hist_bits;
+	bool *gshare;
+	/* Start of each configuration's table in ctrs. */
+	size_t *base;
+	size_t *miss;
+
+	/* Every table back to back: 0 if invalid, else counter + 1. */
+	uint8_t *ctrs;
+	size_t ctrs_size;
+
+	/* Retired outcomes, newest in bit 0. */
+	uint64_t history;
+	size_t branches;
+};
+
+struct bht_sweep *bht_sweep_create(void);
+void bht_sweep_destroy(struct bht_sweep *sw);
+void bht_sweep_clear(struct bht_sweep *sw);
+
+/* Predict and train every configuration on one retired branch. */
+void bht_sweep_update(struct bht_sweep *sw, word_u pc, bool backward, bool taken);
+
+void bht_sweep_print(const struct bht_sweep *sw, size_t insts);
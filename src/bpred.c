@@ -0,0 +1,169 @@
+#include "bpred.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+
+extern const struct bpred_ops bht_ops;
+extern const struct bpred_ops tage_ops;
+extern const struct bpred_ops perceptron_ops;
+extern const struct bpred_ops tournament_ops;
+
+static const struct bpred_ops *const all[] = {
+	&bht_ops,
+	&tage_ops,
+	&perceptron_ops,
+	&tournament_ops,
+};
+
+struct bpred *bpred_create(const char *name)
+{
+	for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+		if (strcmp(all[i]->name, name) == 0) {
+			struct bpred *bp = malloc(sizeof(*bp));
+			assert(bp);
+			bp->ops = all[i];
+			bp->self = all[i]->create();
+			assert(bp->self);
+			return bp;
+		}
+	}
+	return NULL;
+}
+
+void bpred_destroy(struct bpred *bp)
+{
+	if (bp)
+		free(bp->self);
+	free(bp);
+}
+
+void bpred_list(FILE *f)
+{
+	for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++)
+		fprintf(f, "%s%s", i ? " " : "", all[i]->name);
+	fprintf(f, "\n");
+}
+
+_Static_assert(BPRED_HIST_BUF_BITS >= BPRED_HIST_LEN + 2 * ROB_SIZE,
+	"wrong path history could overwrite history still in use");
+_Static_assert((BPRED_HIST_BUF_BITS & (BPRED_HIST_BUF_BITS - 1)) == 0,
+	"history buffer must be a power of two");
+
+void bpred_hist_init(struct bpred_hist *hist)
+{
+	*hist = (struct bpred_hist){ 0 };
+	hist->buf = calloc(BPRED_HIST_BUF_BITS / 64, sizeof(uint64_t));
+	assert(hist->buf);
+}
+
+void bpred_hist_free(struct bpred_hist *hist)
+{
+	free(hist->buf);
+	hist->buf = NULL;
+}
+
+void bpred_hist_reset(struct bpred_hist *hist)
+{
+	*hist = (struct bpred_hist){ .buf = hist->buf, .head = hist->head };
+}
+
+void bpred_hist_shift(struct bpred_hist *hist, word_u pc, bool taken)
+{
+	hist->head++;
+	const size_t b = (0 - hist->head) & (BPRED_HIST_BUF_BITS - 1);
+	const uint64_t bit = (uint64_t)1 << (b % 64);
+	hist->buf[b / 64] = taken ? hist->buf[b / 64] | bit : hist->buf[b / 64] & ~bit;
+	if (hist->valid < BPRED_HIST_LEN)
+		hist->valid++;
+	hist->recent = (hist->recent << 1) | taken;
+}
+
+uint64_t bpred_hist_range(const struct bpred_hist *hist, size_t start, size_t len)
+{
+	assert(len && len <= 64 && start + len <= BPRED_HIST_LEN);
+	if (start >= hist->valid)
+		return 0;
+	const size_t b = (start - hist->head) & (BPRED_HIST_BUF_BITS - 1);
+	const size_t w = b / 64, s = b % 64;
+	uint64_t x = hist->buf[w] >> s;
+	if (s + len > 64)
+		x |= hist->buf[(w + 1) % (BPRED_HIST_BUF_BITS / 64)] << (64 - s);
+	if (len < 64)
+		x &= ((uint64_t)1 << len) - 1;
+	if (start + len > hist->valid)
+		x &= ((uint64_t)1 << (hist->valid - start)) - 1;
+	return x;
+}
+
+int bpred_predict_only(const char *trace, const char *const *names, size_t count)
+{
+	FILE *f = fopen(trace, "rb");
+	if (!f) {
+		fprintf(stderr, "Couldn't open branch trace %s.\n", trace);
+		return -1;
+	}
+
+	struct bpred *bps[count];
+	for (size_t i = 0; i < count; i++) {
+		bps[i] = bpred_create(names[i]);
+		if (!bps[i]) {
+			fprintf(stderr, "Unknown predictor %s, have: ", names[i]);
+			bpred_list(stderr);
+			for (size_t j = 0; j < i; j++)
+				bpred_destroy(bps[j]);
+			fclose(f);
+			return -1;
+		}
+	}
+	struct bpred_hist *hist = calloc(count, sizeof(*hist));
+	struct stats *stats = calloc(count, sizeof(*stats));
+	size_t *miss = calloc(count, sizeof(*miss));
+	assert(hist && stats && miss);
+	for (size_t i = 0; i < count; i++)
+		bpred_hist_init(&hist[i]);
+
+	/* Predict and train straight away: there is no pipeline, so no
+	 * branches in flight. */
+	size_t branches = 0, insts = 0;
+	struct bpred_trace_rec rec;
+	while (fread(&rec, sizeof(rec), 1, f) == 1) {
+		const word_u pc = { .u = rec.pc };
+		const bool taken = rec.insts_taken & 1;
+		const bool backward = rec.insts_taken & 2;
+		branches++;
+		insts += rec.insts_taken >> 2;
+		for (size_t i = 0; i < count; i++) {
+			const enum bpred_dir d = bpred_predict(bps[i], &hist[i], pc);
+			/* Same static fallback as decode: backwards taken. */
+			const bool p = d == BPRED_NONE ? backward : d == BPRED_TAKEN;
+			miss[i] += p != taken;
+			bpred_resolve(bps[i], &hist[i], pc, taken, &stats[i]);
+			bpred_spec_update(bps[i], &hist[i], pc, taken);
+		}
+	}
+	fclose(f);
+	for (size_t i = 0; i < count; i++) {
+		bpred_destroy(bps[i]);
+		bpred_hist_free(&hist[i]);
+	}
+	free(hist);
+	free(stats);
+
+	if (!branches) {
+		fprintf(stderr, "No branches in trace %s.\n", trace);
+		free(miss);
+		return -1;
+	}
+	printf("%lu branches in %lu instructions\n", branches, insts);
+	printf("%-16s%-16s%-16sMPKI\n", "Predictor", "Mispredicts", "Accuracy");
+	for (size_t i = 0; i < count; i++) {
+		char acc[16];
+		snprintf(acc, sizeof(acc), "%.2f%%", 100. * (double)(branches - miss[i]) / (double)branches);
+		printf("%-16s%-16lu%-16s%.3f\n", names[i], miss[i], acc,
+			1000. * (double)miss[i] / (double)insts);
+	}
+	free(miss);
+	return 0;
+}
@@ -0,0 +1,138 @@
+/* Conditional branch predictor interface */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "word.h"
+#include "config.h"
+
+struct stats;
+
+/* Speculative global history, one copy per cycle and a checkpoint in each
+ * ROB entry that can redirect fetch.
+ * Outcomes go into a circular bit buffer shared by every copy, so a copy
+ * is just its position and its folds whatever the history length. Wrong
+ * path outcomes are only ever written past the position of any copy still
+ * live, and the buffer is long enough that they can't wrap round onto
+ * history a live copy can still read. */
+struct bpred_hist {
+	uint64_t *buf;
+	/* Outcomes pushed so far. */
+	size_t head;
+	/* How many of the most recent are real; older ones read as 0. */
+	size_t valid;
+	/* The last 64, newest in bit 0, for short histories. */
+	uint64_t recent;
+	/* Folded copies of the history, for predictors which index with
+	 * them, kept up to date by their spec_update. */
+	uint16_t fold[BPRED_FOLDS];
+};
+
+enum bpred_dir {
+	/* Nothing known, use the static prediction. */
+	BPRED_NONE,
+	BPRED_NOT_TAKEN,
+	BPRED_TAKEN,
+};
+
+struct bpred_ops {
+	const char *name;
+	/* Allocate a cleared predictor. */
+	void *(*create)(void);
+	void (*clear)(void *self);
+	/* At decode, with the history so far. */
+	enum bpred_dir (*predict)(const void *self, const struct bpred_hist *hist, word_u pc);
+	/* Add a predicted outcome to the history. */
+	void (*spec_update)(struct bpred_hist *hist, word_u pc, bool taken);
+	/* Train at retire with the history the branch was predicted with.
+	 * Returns whether the branch would now be predicted taken. */
+	bool (*resolve)(void *self, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats);
+	/* Back to the checkpoint taken before a mispredicted branch, which
+	 * went the other way. NULL to restore and spec_update. */
+	void (*recover)(struct bpred_hist *hist, const struct bpred_hist *checkpoint, word_u pc, bool taken);
+};
+
+struct bpred {
+	const struct bpred_ops *ops;
+	void *self;
+};
+
+/* NULL for an unknown name. */
+struct bpred *bpred_create(const char *name);
+void bpred_destroy(struct bpred *bp);
+void bpred_list(FILE *f);
+
+static inline void bpred_clear(struct bpred *bp)
+{
+	bp->ops->clear(bp->self);
+}
+
+static inline enum bpred_dir bpred_predict(const struct bpred *bp, const struct bpred_hist *hist, word_u pc)
+{
+	return bp->ops->predict(bp->self, hist, pc);
+}
+
+static inline void bpred_spec_update(const struct bpred *bp, struct bpred_hist *hist, word_u pc, bool taken)
+{
+	bp->ops->spec_update(hist, pc, taken);
+}
+
+static inline bool bpred_resolve(struct bpred *bp, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats)
+{
+	return bp->ops->resolve(bp->self, hist, pc, taken, stats);
+}
+
+static inline void bpred_recover(const struct bpred *bp, struct bpred_hist *hist,
+	const struct bpred_hist *checkpoint, word_u pc, bool taken)
+{
+	if (bp->ops->recover) {
+		bp->ops->recover(hist, checkpoint, pc, taken);
+	} else {
+		*hist = *checkpoint;
+		bp->ops->spec_update(hist, pc, taken);
+	}
+}
+
+void bpred_hist_init(struct bpred_hist *hist);
+void bpred_hist_free(struct bpred_hist *hist);
+/* Empty the history, without touching older copies. */
+void bpred_hist_reset(struct bpred_hist *hist);
+
+/* Push an outcome: spec_update for predictors not folding. */
+void bpred_hist_shift(struct bpred_hist *hist, word_u pc, bool taken);
+
+/* The outcome i branches ago, 0 the newest. */
+static inline bool bpred_hist_bit(const struct bpred_hist *hist, size_t i)
+{
+	if (i >= hist->valid)
+		return 0;
+	/* Stored newest first from the head back, so ranges are ascending. */
+	const size_t b = (i - hist->head) & (BPRED_HIST_BUF_BITS - 1);
+	return (hist->buf[b / 64] >> (b % 64)) & 1;
+}
+
+/* len <= 64 outcomes from start branches ago, the newest in bit 0. */
+uint64_t bpred_hist_range(const struct bpred_hist *hist, size_t start, size_t len);
+
+/* Incremental folding: push in the newest outcome and take out the one
+ * len ago, leaving len outcomes xor folded into width bits. */
+static inline uint16_t bpred_fold(uint16_t folded, size_t width, size_t len, bool in, bool out)
+{
+	uint32_t f = ((uint32_t)folded << 1) | in;
+	f ^= (uint32_t)out << (len % width);
+	f ^= f >> width;
+	return f & ((1u << width) - 1);
+}
+
+/* One record per retired conditional branch in a branch trace. */
+struct bpred_trace_rec {
+	uint32_t pc;
+	/* Instructions retired since the previous record, including this
+	 * branch, shifted up by two. Bit 1 is set for backward branches,
+	 * bit 0 if taken. */
+	uint32_t insts_taken;
+};
+
+/* Replay a branch trace through each predictor named, printing accuracy. */
+int bpred_predict_only(const char *trace, const char *const *names, size_t count);
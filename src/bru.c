@@ -7,8 +7,10 @@
 
 word_u bru_act_target(const bru_t *bru)
 {
+	const bool jalr = bru->op == BRU_OP_JALR_TO_ROB || bru->op == BRU_OP_JALR_TO_FETCH;
 	const word_u addr_taken = (word_u) { .u = bru->imm.u };
-	assert(~addr_taken.u & 1u);
+	/* A JALR's imm is an offset, and may be odd. */
+	assert(jalr || (~addr_taken.u & 1u));
 	const word_u addr_not = (word_u) { .u = bru->pc.u + 4u };
 	assert(~addr_not.u & 1u);
 	word_u exp;
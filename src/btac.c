@@ -1,15 +1,156 @@
 #include "btac.h"
 
-void btac_update(struct btac *next, word_u pc, word_u taddr)
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+enum {
+	RRIP_MAX = 3,
+	RRIP_INSERT = 2,
+};
+
+static size_t btac_set(word_u pc)
+{
+	return (pc.u / 4) & BTAC_SET_MASK;
+}
+
+static uint16_t btac_tag(word_u pc)
+{
+	return (pc.u / 4 / BTAC_SETS) & BTAC_TAG_MASK;
+}
+
+static btac_entry_t *btac_find(const struct btac *btac, word_u pc)
+{
+	btac_entry_t *set = (btac_entry_t *)btac->sets[btac_set(pc)];
+	const uint16_t tag = btac_tag(pc);
+	for (size_t w = 0; w < BTAC_WAYS; w++)
+		if (set[w].valid && set[w].tag == tag)
+			return &set[w];
+	return NULL;
+}
+
+void btac_init(struct btac *btac, size_t mem_words)
+{
+	*btac = (struct btac){ 0 };
+	btac->seen_words = mem_words;
+	btac->seen = calloc((mem_words + 7) / 8, 1);
+	assert(btac->seen);
+}
+
+void btac_free(struct btac *btac)
+{
+	free(btac->seen);
+	btac->seen = NULL;
+}
+
+void btac_clear(struct btac *btac)
+{
+	memset(btac->sets, 0, sizeof(btac->sets));
+	memset(btac->shadow, 0, sizeof(btac->shadow));
+	memset(btac->seen, 0, (btac->seen_words + 7) / 8);
+}
+
+size_t btac_lookup(const struct btac *btac, word_u pc, size_t width, word_u *taddr)
+{
+	/* All of the window's sets are read at once in hardware. */
+	for (size_t i = 0; i < width; i++) {
+		const btac_entry_t *e = btac_find(btac, (word_u){ .u = pc.u + i * 4 });
+		if (e && e->taken) {
+			*taddr = e->taddr;
+			return i;
+		}
+	}
+	return width;
+}
+
+enum btac_miss btac_classify(const struct btac *btac, word_u pc)
+{
+	if (btac_find(btac, pc))
+		return BTAC_MISS_NONE;
+	const size_t word = pc.u / 4;
+	if (word >= btac->seen_words || !(btac->seen[word / 8] & (1u << (word % 8))))
+		return BTAC_MISS_COLD;
+	for (size_t i = 0; i < BTAC_SIZE; i++)
+		if (btac->shadow[i].u == pc.u)
+			return BTAC_MISS_CONFLICT;
+	return BTAC_MISS_CAPACITY;
+}
+
+static void btac_touch(btac_entry_t *set, btac_entry_t *e)
+{
+	if (opt_btac_rrip) {
+		e->age = 0;
+		return;
+	}
+	const uint8_t old = e->valid ? e->age : BTAC_WAYS - 1;
+	for (size_t w = 0; w < BTAC_WAYS; w++)
+		if (&set[w] != e && set[w].valid && set[w].age < old)
+			set[w].age++;
+	e->age = 0;
+}
+
+static btac_entry_t *btac_victim(btac_entry_t *set)
+{
+	for (size_t w = 0; w < BTAC_WAYS; w++)
+		if (!set[w].valid)
+			return &set[w];
+	if (opt_btac_rrip) {
+		for (;;) {
+			for (size_t w = 0; w < BTAC_WAYS; w++)
+				if (set[w].age >= RRIP_MAX)
+					return &set[w];
+			for (size_t w = 0; w < BTAC_WAYS; w++)
+				set[w].age++;
+		}
+	}
+	btac_entry_t *victim = &set[0];
+	for (size_t w = 1; w < BTAC_WAYS; w++)
+		if (set[w].age > victim->age)
+			victim = &set[w];
+	return victim;
+}
+
+static void btac_shadow_touch(struct btac *btac, word_u pc)
+{
+	size_t i;
+	for (i = 0; i < BTAC_SIZE - 1 && btac->shadow[i].u != pc.u; i++)
+		;
+	memmove(&btac->shadow[1], &btac->shadow[0], i * sizeof(btac->shadow[0]));
+	btac->shadow[0] = pc;
+}
+
+void btac_update(struct btac *next, word_u pc, word_u taddr, bool taken)
 {
 	if (opt_nospec)
 		return;
 
-	if (taddr.u) {
-		next->buffer[(pc.u / 4) & BTAC_INDEX_MASK].br_pc = pc;
+	btac_entry_t *e = btac_find(next, pc);
+	if (!taken) {
+		if (e)
+			e->taken = false;
+		return;
+	}
+
+	btac_entry_t *set = next->sets[btac_set(pc)];
+	if (!e) {
+		e = btac_victim(set);
+		if (e->valid)
+			tracei("[btac] %x evicts tag %x\n", pc.u, e->tag);
+		if (opt_btac_rrip) {
+			*e = (btac_entry_t){ .valid = 1, .tag = btac_tag(pc), .age = RRIP_INSERT };
+		} else {
+			btac_touch(set, e);
+			*e = (btac_entry_t){ .valid = 1, .tag = btac_tag(pc) };
+		}
 	} else {
-		next->buffer[(pc.u / 4) & BTAC_INDEX_MASK].br_pc = (word_u) { .u = 0 };
+		btac_touch(set, e);
 	}
-	next->buffer[(pc.u / 4) & BTAC_INDEX_MASK].taddr = taddr;
-}
+	e->taken = true;
+	e->taddr = taddr;
 
+	btac_shadow_touch(next, pc);
+	const size_t word = pc.u / 4;
+	if (word < next->seen_words)
+		next->seen[word / 8] |= 1u << (word % 8);
+}
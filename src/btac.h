@@ -1,16 +1,53 @@
-/* BTAC */
+/* BTAC
+ * Set associative, with partial tags, so an entry can hit for the wrong
+ * instruction. Decode checks any hit against what it decodes. */
 #pragma once
+#include <stdint.h>
 #include "config.h"
 #include "word.h"
 typedef struct {
-	word_u br_pc;
+	bool valid;
+	/* Trained taken last time: fetch only redirects on these, others
+	 * keep their slot so they don't need reinserting. */
+	bool taken;
+	uint16_t tag;
+	/* LRU position (0 most recent), or RRIP re-reference value. */
+	uint8_t age;
 	word_u taddr;
 } btac_entry_t;
 
 struct btac {
-	btac_entry_t buffer[BTAC_SIZE];
+	btac_entry_t sets[BTAC_SETS][BTAC_WAYS];
+
+	/* Miss classification only, not part of the predictor.
+	 * Fully associative LRU of the same size, most recent first: a miss
+	 * which would hit here is a conflict miss. */
+	word_u shadow[BTAC_SIZE];
+	/* One bit per instruction word ever inserted, else a cold miss.
+	 * Shared by all cycles' copies. */
+	uint8_t *seen;
+	size_t seen_words;
+};
+
+enum btac_miss {
+	BTAC_MISS_NONE,
+	BTAC_MISS_COLD,
+	BTAC_MISS_CAPACITY,
+	BTAC_MISS_CONFLICT,
 };
 
-/* Replace an entry in the BTAC. */
-void btac_update(struct btac *next, word_u pc, word_u taddr);
+void btac_init(struct btac *btac, size_t mem_words);
+void btac_free(struct btac *btac);
+void btac_clear(struct btac *btac);
+
+/* First instruction of the width starting at pc to hit a taken entry, or
+ * width if none. */
+size_t btac_lookup(const struct btac *btac, word_u pc, size_t width, word_u *taddr);
+
+/* Why pc has no entry, if it hasn't. */
+enum btac_miss btac_classify(const struct btac *btac, word_u pc);
+
+/* Train with a resolved branch. Not taken branches only update an entry
+ * already there. */
+void btac_update(struct btac *next, word_u pc, word_u taddr, bool taken);
 
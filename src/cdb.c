@@ -24,6 +24,17 @@ const cdb_entry *cdb_with_rob(const struct cdb *cdb, size_t rob_id)
 	return NULL;
 }
 
+const cdb_entry *cdb_with_preg(const struct cdb *cdb, preg_t preg)
+{
+	assert(preg);
+	for (size_t i = 0; i < CDB_WIDTH; i++) {
+		if (cdb->buffer[i].rob_id && cdb->buffer[i].preg == preg) {
+			return &cdb->buffer[i];
+		}
+	}
+	return NULL;
+}
+
 void cdb_clear(struct cdb *cdb)
 {
 	for (size_t i = 0; i < CDB_WIDTH; i++) {
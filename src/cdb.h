@@ -1,10 +1,13 @@
 #pragma once
 
 #include "config.h"
+#include "prf.h"
 #include "word.h"
 
 typedef struct {
 	size_t rob_id;
+	/* Physical register written, 0 for branches. */
+	preg_t preg;
 	word_u data;
 	bool exception;
 } cdb_entry;
@@ -19,6 +22,9 @@ cdb_entry *cdb_find_free(struct cdb *cdb);
 /* Any allocated CDB with this ROB id. */
 const cdb_entry *cdb_with_rob(const struct cdb *cdb, size_t rob_id);
 
+/* Any allocated CDB writing this physical register. */
+const cdb_entry *cdb_with_preg(const struct cdb *cdb, preg_t preg);
+
 /* Clear the CDB. */
 void cdb_clear(struct cdb *cdb);
 
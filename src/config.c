@@ -3,9 +3,21 @@
 bool feature_2level = true;
 bool feature_store_forward = true;
 bool feature_branch_bht_btac = true;
+bool feature_storeset = true;
+bool feature_ooo_loads = true;
+bool feature_ittage = true;
+bool feature_loop = true;
+bool feature_early_recovery = true;
+bool feature_move_elim = true;
 
 bool opt_clearhistoncall = false;
 bool opt_1bitbht = false;
 bool opt_nospec = false;
 bool opt_gshare = false;
 bool opt_nostorechk = false;
+bool opt_btac_rrip = false;
+bool opt_ras_flush = false;
+
+enum issue_policy opt_issue = ISSUE_OLDEST;
+
+size_t opt_fetch_taken = 2;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 enum {
 	MEM_SIZE = 1024ul * 1024 * 1024 * 2,
@@ -13,8 +14,17 @@ enum {
 	ALU_COUNT = PIPELINE_WIDTH,
 	LSU_COUNT = 2,
 	BRU_COUNT = 1,
+	/* RV32M: a pipelined multiplier and an iterative divider. */
+	MUL_COUNT = 1,
+	DIV_COUNT = 1,
+	/* Units whose results go through the event queue, in this order. */
+	FU_COUNT = ALU_COUNT + MUL_COUNT + DIV_COUNT,
 
 	ISSUE_WIDTH = PIPELINE_WIDTH,
+	/* Fetched instructions waiting for decode, and predicted blocks
+	 * waiting for fetch. */
+	FETCH_BUF_SIZE = 4 * ISSUE_WIDTH,
+	FTQ_SIZE = 8,
 	RETIRE_WIDTH = PIPELINE_WIDTH,
 
 	RS_COUNT = 24,
@@ -22,31 +32,111 @@ enum {
 	LDB_SIZE = 8,
 	LDB_INDEX_MASK = LDB_SIZE - 1,
 
+	/* At most 64, one bit per entry in the index. */
+	STQ_SIZE = 32,
+	STQ_INDEX_MASK = STQ_SIZE - 1,
+	STQ_HASH_SIZE = 64,
+	STQ_HASH_MASK = STQ_HASH_SIZE - 1,
+
+	SSIT_SIZE = 512,
+	SSIT_INDEX_MASK = SSIT_SIZE - 1,
+	/* Number of store sets. */
+	LFST_SIZE = 64,
+	LFST_INDEX_MASK = LFST_SIZE - 1,
+	STORESET_CLEAR_CYCLES = 1 << 20,
+
 	ROB_SIZE = 32,
 	ROB_INDEX_MASK = ROB_SIZE - 1,
 
+	/* Physical registers, x0 included. REG_COUNT + ROB_SIZE never runs out. */
+	PRF_SIZE = REG_COUNT + ROB_SIZE,
+
 	BHT_SIZE = 128,
 	BHT_INDEX_MASK = BHT_SIZE - 1,
 
 	GLOBAL_HISTORY_BITS = 3,
 	GLOBAL_HISTORY_MASK = (1 << GLOBAL_HISTORY_BITS) - 1,
 
-	BTAC_SIZE = 32,
-	BTAC_INDEX_MASK = BTAC_SIZE - 1,
-
-	RAS_SIZE = 4,
+	/* Range of BHT configurations tried by bhtsweep. */
+	BHT_SWEEP_MIN_INDEX_BITS = 4,
+	BHT_SWEEP_MAX_INDEX_BITS = 14,
+	BHT_SWEEP_MAX_HIST_BITS = 12,
+
+	TAGE_TABLES = 7,
+	TAGE_INDEX_BITS = 10,
+	TAGE_TABLE_SIZE = 1 << TAGE_INDEX_BITS,
+	TAGE_BASE_SIZE = 4096,
+	TAGE_MIN_HIST = 5,
+	TAGE_MAX_HIST = 141,
+
+	/* Global history for the conditional predictors: longest usable, and
+	 * the buffer behind it. */
+	BPRED_HIST_LEN = 640,
+	BPRED_HIST_BUF_BITS = 4096,
+	BPRED_FOLDS = 24,
+
+	PERCEPTRON_TABLES = 16,
+	PERCEPTRON_INDEX_BITS = 10,
+	PERCEPTRON_TABLE_SIZE = 1 << PERCEPTRON_INDEX_BITS,
+
+	/* Local history per PC, and how much of it picks a counter. */
+	TOURN_LOCAL_SIZE = 1024,
+	TOURN_LOCAL_PHT_SIZE = 1024,
+	TOURN_GLOBAL_SIZE = 4096,
+	TOURN_CHOOSER_SIZE = 4096,
+
+	LOOP_SIZE = 64,
+	LOOP_INDEX_MASK = LOOP_SIZE - 1,
+
+	ITTAGE_TABLES = 4,
+	ITTAGE_INDEX_BITS = 9,
+	ITTAGE_TABLE_SIZE = 1 << ITTAGE_INDEX_BITS,
+
+	BTAC_SETS = 8,
+	BTAC_SET_MASK = BTAC_SETS - 1,
+	BTAC_WAYS = 4,
+	BTAC_SIZE = BTAC_SETS * BTAC_WAYS,
+	BTAC_TAG_BITS = 8,
+	BTAC_TAG_MASK = (1 << BTAC_TAG_BITS) - 1,
+
+	RAS_SIZE = 16,
 	RAS_INDEX_MASK = RAS_SIZE - 1,
 
 	CDB_WIDTH = PIPELINE_WIDTH,
+
+	/* Results in flight in the ALUs, multipliers and dividers. */
+	FU_EVENTS_SIZE = 64,
 };
 
 extern bool feature_2level;
 extern bool feature_store_forward;
 extern bool feature_branch_bht_btac;
+extern bool feature_storeset;
+extern bool feature_ooo_loads;
+extern bool feature_ittage;
+extern bool feature_loop;
+extern bool feature_early_recovery;
+extern bool feature_move_elim;
 
 extern bool opt_clearhistoncall;
 extern bool opt_1bitbht;
 extern bool opt_nospec;
 extern bool opt_gshare;
 extern bool opt_nostorechk;
+extern bool opt_btac_rrip;
+extern bool opt_ras_flush;
+
+/* Which of the ready ops in a reservation station class goes first. */
+enum issue_policy {
+	ISSUE_OLDEST,
+	/* ALU ops a waiting branch needs, then the oldest. */
+	ISSUE_BRANCH_FIRST,
+	/* ALU ops a waiting load needs, then the oldest. */
+	ISSUE_LOAD_FIRST,
+};
+
+extern enum issue_policy opt_issue;
+
+/* Predicted-taken branches the front end follows in a cycle. */
+extern size_t opt_fetch_taken;
 
@@ -1,5 +1,9 @@
 #include "debugger.h"
 
+#include "bht.h"
+
+volatile sig_atomic_t debugger_pause = 1;
+
 void debugger_print(const state_t *next, const char *arg)
 {
 	if (strcmp(arg, "rob") == 0) {
@@ -11,12 +15,12 @@ void debugger_print(const state_t *next, const char *arg)
 				rob->id,
 				rob->pc.u,
 				rob_type_str(rob->type),
-				rob->ready
+				rob_mask_test(&next->rob_ready, i)
 			);
 			switch (rob->type) {
 			case ROB_INSTR_REGISTER:
-				printf("%x\t%s\n", rob->data.reg.val.u,
-					reg_name(rob->data.reg.val.u));
+				printf("%x\t%s (p%u)\n", next->prf->val[rob->preg].u,
+					reg_name(rob->data.reg.dest.u), rob->preg);
 			break; case ROB_INSTR_STORE:
 				printf("%x\t%x\n", rob->data.reg.val.u,
 					rob->data.reg.val.u);
@@ -31,11 +35,10 @@ void debugger_print(const state_t *next, const char *arg)
 		for (size_t i = 0; i < REG_COUNT; i++) {
 			if ((i & 3) == 0)
 				printf("\n");
-			printf("%5s: %.8x (rs %lu)\t", reg_name(i), next->arf[i].dat.u, next->arf[i].rob_id);
+			printf("%5s: %.8x (p%u)\t", reg_name(i), prf_arch_val(next->prf, i).u, next->prf->spec[i]);
 		}
 		printf("\n");
 	} else if (strcmp(arg, "rs") == 0) {
-		printf("Ldb tail: %lu, head: %lu\n", next->ldb_tail, next->ldb_head);
 		printf("\tpc\ttype\tvk\tqk\t\tvj\tqj\t\n");
 		for (size_t i = 0; i < RS_COUNT + LDB_SIZE; i++) {
 			const rs_t *rs;
@@ -52,15 +55,31 @@ void debugger_print(const state_t *next, const char *arg)
 					rs->qk, rs->vk.u);
 			}
 		}
+	} else if (strcmp(arg, "stq") == 0) {
+		printf("Stq tail: %lu, head: %lu\n", next->stq.tail, next->stq.head);
+		printf("\trob\tpc\taddr\tval\n");
+		for (size_t i = next->stq.tail; i != next->stq.head; i = (i + 1) & STQ_INDEX_MASK) {
+			const stq_entry_t *e = &next->stq.buffer[i];
+			printf("%lu\t%lu\t%x\t%x\t", i, e->rob_id, e->pc.u, e->addr.u);
+			if (e->val_ready)
+				printf("%x\n", e->val.u);
+			else
+				printf("-\n");
+		}
 	} else if (strcmp(arg, "bht") == 0) {
+		if (next->bpred->ops != &bht_ops) {
+			printf("Predictor is %s\n", next->bpred->ops->name);
+			return;
+		}
+		const struct bht *bht = next->bpred->self;
 		for (size_t i = 0; i < BHT_SIZE; i++) {
-			if (next->bht.buffer[i].valid) {
-				printf("%x: %d\n", next->bht.buffer[i].debug_last_pc.u, next->bht.buffer[i].ctr);
+			if (bht->buffer[i].valid) {
+				printf("%x: %d\n", bht->buffer[i].debug_last_pc.u, bht->buffer[i].ctr);
 			}
 		}
 	} else if (strcmp(arg, "ras") == 0) {
-		printf("Head: %lu, %x\n", next->ras.head_ptr, next->ras.head.u);
-		for (size_t i = next->ras.head_ptr; ((i - 1) & RAS_INDEX_MASK) != next->ras.head_ptr; i = (i - 1) & RAS_INDEX_MASK) {
+		printf("Top: %lu, %lu entries\n", next->ras.tos, next->ras.count);
+		for (size_t n = 0, i = next->ras.tos; n < next->ras.count; n++, i = (i - 1) & RAS_INDEX_MASK) {
 			printf("%lu - %x\n", i, next->ras.buffer[i].u);
 		}
 	} else {
@@ -71,7 +90,8 @@ void debugger_print(const state_t *next, const char *arg)
 int debugger(state_t *next, const uint8_t *mem /*, struct list_head breakpoints */)
 {
 	if (debugger_pause) {
-		printf("PC: %x ish\n", next->pc_last.u);
+		printf("PC: %x ish\n", fetch_buf_count(&next->fetch_buf)
+			? fetch_buf_at(&next->fetch_buf, 0)->pc.u : next->pc_fetch.u);
 	}
 	while (debugger_pause) {
 		fputs("\n>", stdout);
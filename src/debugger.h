@@ -4,7 +4,7 @@
 
 #include "pipeline.h"
 
-static volatile sig_atomic_t debugger_pause = 1;
+extern volatile sig_atomic_t debugger_pause;
 
 struct breakpoint {
 	word_u addr;
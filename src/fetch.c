@@ -0,0 +1,46 @@
+#include "fetch.h"
+
+#include <assert.h>
+
+void ftq_push(struct ftq *q, const struct fetch_block *block)
+{
+	assert(ftq_count(q) < FTQ_SIZE);
+	assert(block->count && block->count <= ISSUE_WIDTH);
+	q->block[q->head++ % FTQ_SIZE] = *block;
+}
+
+struct fetch_block *ftq_oldest(struct ftq *q)
+{
+	assert(ftq_count(q));
+	return &q->block[q->tail % FTQ_SIZE];
+}
+
+void ftq_pop(struct ftq *q)
+{
+	assert(ftq_count(q));
+	q->tail++;
+}
+
+void fetch_buf_push(struct fetch_buf *b, const fetched_instr_t *instr)
+{
+	assert(fetch_buf_count(b) < FETCH_BUF_SIZE);
+	b->instr[b->head++ % FETCH_BUF_SIZE] = *instr;
+}
+
+const fetched_instr_t *fetch_buf_at(const struct fetch_buf *b, size_t i)
+{
+	assert(i < fetch_buf_count(b));
+	return &b->instr[(b->tail + i) % FETCH_BUF_SIZE];
+}
+
+void fetch_buf_pop(struct fetch_buf *b, size_t n)
+{
+	assert(n <= fetch_buf_count(b));
+	b->tail += n;
+}
+
+void fetch_flush(struct ftq *q, struct fetch_buf *b)
+{
+	q->tail = q->head;
+	b->tail = b->head;
+}
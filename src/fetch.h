@@ -0,0 +1,63 @@
+/* Front end queues.
+ * The fetch target queue holds blocks the BTAC has picked, so prediction
+ * runs ahead of instruction fetch. The fetch buffer holds fetched
+ * instructions until decode takes them, so fetch runs ahead of decode. */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+#include "word.h"
+
+typedef struct {
+	word_u pc;
+	word_u instr;
+	/* Fetch was redirected after this to btac_taddr. */
+	bool btac_hit;
+	word_u btac_taddr;
+} fetched_instr_t;
+
+/* Up to ISSUE_WIDTH instructions from pc, ending at the BTAC hit if any. */
+struct fetch_block {
+	word_u pc;
+	size_t count;
+	bool btac_hit;
+	word_u btac_taddr;
+};
+
+/* Same convention as the ROB:
+ * Head - next insertion,
+ * Tail - oldest.
+ * Both count up forever, and index modulo the size. */
+struct ftq {
+	struct fetch_block block[FTQ_SIZE];
+	size_t head, tail;
+};
+
+struct fetch_buf {
+	fetched_instr_t instr[FETCH_BUF_SIZE];
+	size_t head, tail;
+};
+
+static inline size_t ftq_count(const struct ftq *q)
+{
+	return q->head - q->tail;
+}
+
+static inline size_t fetch_buf_count(const struct fetch_buf *b)
+{
+	return b->head - b->tail;
+}
+
+void ftq_push(struct ftq *q, const struct fetch_block *block);
+struct fetch_block *ftq_oldest(struct ftq *q);
+void ftq_pop(struct ftq *q);
+
+void fetch_buf_push(struct fetch_buf *b, const fetched_instr_t *instr);
+/* i-th oldest instruction. */
+const fetched_instr_t *fetch_buf_at(const struct fetch_buf *b, size_t i);
+/* Drop the n oldest. */
+void fetch_buf_pop(struct fetch_buf *b, size_t n);
+
+/* Empty both, everything in them is on the wrong path. */
+void fetch_flush(struct ftq *q, struct fetch_buf *b);
@@ -0,0 +1,64 @@
+#include "fu.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* ALU ops single cycle and everything but the divider fully pipelined.
+ * The divider adds a cycle per quotient bit to its latency and takes no
+ * new op until it's done, so its interval isn't used. */
+struct fu_timing fu_timing[FU_CLASS_COUNT] = {
+	[FU_ADD] = { 1, 1 },
+	[FU_LOGIC] = { 1, 1 },
+	[FU_SHIFT] = { 1, 1 },
+	[FU_MUL] = { 3, 1 },
+	[FU_DIV] = { 2, 0 },
+};
+
+const char *fu_class_str(enum fu_class c)
+{
+	switch (c) {
+	case FU_ADD:
+		return "add";
+	case FU_LOGIC:
+		return "logic";
+	case FU_SHIFT:
+		return "shift";
+	case FU_MUL:
+		return "mul";
+	case FU_DIV:
+		return "div";
+	default:
+		return "invalid";
+	}
+}
+
+enum fu_class fu_class_parse(const char *name)
+{
+	for (size_t c = 0; c < FU_CLASS_COUNT; c++)
+		if (strcmp(name, fu_class_str(c)) == 0)
+			return c;
+	return FU_CLASS_COUNT;
+}
+
+void fu_events_push(struct fu_events *q, const struct fu_event *e)
+{
+	assert(!fu_events_full(q));
+	size_t i = q->count++;
+	for (; i && q->ev[i - 1].due > e->due; i--)
+		q->ev[i] = q->ev[i - 1];
+	q->ev[i] = *e;
+}
+
+const struct fu_event *fu_events_due(const struct fu_events *q, size_t clk)
+{
+	if (q->count && q->ev[0].due <= clk)
+		return &q->ev[0];
+	return NULL;
+}
+
+void fu_events_pop(struct fu_events *q)
+{
+	assert(q->count);
+	memmove(&q->ev[0], &q->ev[1], (q->count - 1) * sizeof(q->ev[0]));
+	q->count--;
+}
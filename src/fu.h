@@ -0,0 +1,64 @@
+/* Functional unit timing.
+ * Each class of op has a latency and an initiation interval: a unit takes
+ * a new op every interval cycles and its result is due latency cycles
+ * after issue. Results wait in an event queue until they are due. */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+#include "prf.h"
+#include "word.h"
+
+enum fu_class {
+	FU_ADD,
+	FU_LOGIC,
+	FU_SHIFT,
+	FU_MUL,
+	/* Iterative, see mdu_latency(). */
+	FU_DIV,
+
+	FU_CLASS_COUNT,
+};
+
+struct fu_timing {
+	size_t latency;
+	size_t interval;
+};
+
+/* Indexed by enum fu_class, set from the command line. */
+extern struct fu_timing fu_timing[FU_CLASS_COUNT];
+
+/* Class by name as given on the command line, or FU_CLASS_COUNT. */
+enum fu_class fu_class_parse(const char *name);
+
+const char *fu_class_str(enum fu_class c);
+
+/* A result due on the CDB. */
+struct fu_event {
+	size_t due;
+	/* Unit it came from. */
+	size_t unit;
+	size_t rob_id;
+	preg_t dest;
+	word_u data;
+};
+
+/* Ordered by due cycle, in issue order within a cycle. */
+struct fu_events {
+	struct fu_event ev[FU_EVENTS_SIZE];
+	size_t count;
+};
+
+static inline bool fu_events_full(const struct fu_events *q)
+{
+	return q->count == FU_EVENTS_SIZE;
+}
+
+void fu_events_push(struct fu_events *q, const struct fu_event *e);
+
+/* Earliest event if it is due by clk, else NULL. */
+const struct fu_event *fu_events_due(const struct fu_events *q, size_t clk);
+
+/* Drop the earliest event. */
+void fu_events_pop(struct fu_events *q);
@@ -0,0 +1,104 @@
+#include "fuse.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "decode.h"
+
+bool fuse_enabled[FUSE_COUNT] = {
+	[FUSE_LUI_ADDI] = true,
+	[FUSE_AUIPC_ADDI] = true,
+	[FUSE_SLLI_ADD] = true,
+	[FUSE_AUIPC_JALR] = true,
+};
+
+const char *fuse_idiom_str(enum fuse_idiom f)
+{
+	switch (f) {
+	case FUSE_LUI_ADDI:
+		return "lui+addi";
+	case FUSE_AUIPC_ADDI:
+		return "auipc+addi";
+	case FUSE_SLLI_ADD:
+		return "slli+add";
+	case FUSE_AUIPC_JALR:
+		return "auipc+jalr";
+	default:
+		return "none";
+	}
+}
+
+enum fuse_idiom fuse_parse(const char *name)
+{
+	for (size_t f = FUSE_NONE + 1; f < FUSE_COUNT; f++)
+		if (strcmp(name, fuse_idiom_str(f)) == 0)
+			return f;
+	return FUSE_COUNT;
+}
+
+static bool is_addi(word_u i)
+{
+	return instr_opcode(i).u == OPC_REG_IMM && instr_funct3(i).u == 0;
+}
+
+static enum fuse_idiom match(word_u a, word_u b)
+{
+	const uint8_t rd = instr_rd(a);
+	if (!rd)
+		return FUSE_NONE;
+	switch (instr_opcode(a).u) {
+	case OPC_LUI:
+		if (is_addi(b) && instr_rd(b) == rd && instr_rs1(b) == rd)
+			return FUSE_LUI_ADDI;
+		break;
+	case OPC_AUIPC:
+		if (is_addi(b) && instr_rd(b) == rd && instr_rs1(b) == rd)
+			return FUSE_AUIPC_ADDI;
+		/* A tail call leaves rd behind, so only a call. */
+		if (instr_opcode(b).u == OPC_JALR && instr_rd(b) == rd && instr_rs1(b) == rd)
+			return FUSE_AUIPC_JALR;
+		break;
+	case OPC_REG_IMM:
+		/* slli: funct3 1, and funct7 0 in the top of the immediate. */
+		if (instr_funct3(a).u != 1 || instr_funct7(a).u != 0)
+			break;
+		if (instr_opcode(b).u != OPC_REG_REG || instr_funct3(b).u != 0
+				|| instr_funct7(b).u != 0 || instr_rd(b) != rd)
+			break;
+		/* Exactly one of the add's sources is the shifted value. */
+		if ((instr_rs1(b) == rd) != (instr_rs2(b) == rd))
+			return FUSE_SLLI_ADD;
+		break;
+	}
+	return FUSE_NONE;
+}
+
+enum fuse_idiom fuse_match(const fetched_instr_t *a, const fetched_instr_t *b)
+{
+	/* Fetch went elsewhere after a, or b isn't the jump and fetch went
+	 * elsewhere after it: either way not the pair it looks like. */
+	if (a->btac_hit || b->pc.u != a->pc.u + 4)
+		return FUSE_NONE;
+	const enum fuse_idiom f = match(a->instr, b->instr);
+	if (f == FUSE_NONE || !fuse_enabled[f])
+		return FUSE_NONE;
+	if (b->btac_hit && f != FUSE_AUIPC_JALR)
+		return FUSE_NONE;
+	return f;
+}
+
+word_u fuse_value(enum fuse_idiom f, const fetched_instr_t *a, const fetched_instr_t *b)
+{
+	const uint32_t lo = instr_imm_itype(b->instr).u;
+	switch (f) {
+	case FUSE_LUI_ADDI:
+		return (word_u) { .u = instr_imm_utype(a->instr).u + lo };
+	case FUSE_AUIPC_ADDI:
+		return (word_u) { .u = a->pc.u + instr_imm_utype(a->instr).u + lo };
+	case FUSE_AUIPC_JALR:
+		/* jalr clears the low bit. */
+		return (word_u) { .u = (a->pc.u + instr_imm_utype(a->instr).u + lo) & ~1u };
+	default:
+		assert(0);
+	}
+}
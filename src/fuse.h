@@ -0,0 +1,36 @@
+/* Macro-op fusion.
+ * Pairs of adjacent instructions decode recognises and sends down the
+ * pipeline as a single op, taking one ROB entry, RS and register. */
+#pragma once
+
+#include <stdbool.h>
+#include "fetch.h"
+#include "word.h"
+
+enum fuse_idiom {
+	FUSE_NONE,
+	/* lui rd, hi; addi rd, rd, lo: a constant, known at decode. */
+	FUSE_LUI_ADDI,
+	/* auipc rd, hi; addi rd, rd, lo: an address, likewise. */
+	FUSE_AUIPC_ADDI,
+	/* slli rd, rs, sh; add rd, rd, rt: an indexed address, one ALU op. */
+	FUSE_SLLI_ADD,
+	/* auipc rd, hi; jalr rd, lo(rd): a far call, a direct jump. */
+	FUSE_AUIPC_JALR,
+
+	FUSE_COUNT,
+};
+
+/* Indexed by enum fuse_idiom, set from the command line. */
+extern bool fuse_enabled[FUSE_COUNT];
+
+const char *fuse_idiom_str(enum fuse_idiom f);
+
+/* Idiom by name as given on the command line, or FUSE_COUNT. */
+enum fuse_idiom fuse_parse(const char *name);
+
+/* What a and then b make, if it's enabled. */
+enum fuse_idiom fuse_match(const fetched_instr_t *a, const fetched_instr_t *b);
+
+/* The constant, address or call target of a pair known at decode. */
+word_u fuse_value(enum fuse_idiom f, const fetched_instr_t *a, const fetched_instr_t *b);
@@ -0,0 +1,130 @@
+#include "ittage.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "util.h"
+
+/* Histories fit in the recent word, so fold them straight from it. */
+static const size_t hist_len[ITTAGE_TABLES] = { 4, 10, 24, 60 };
+static const size_t tag_bits[ITTAGE_TABLES] = { 9, 10, 11, 12 };
+
+enum {
+	CTR_MAX = 3,
+	U_MAX = 3,
+};
+
+struct lookup {
+	size_t idx[ITTAGE_TABLES];
+	uint16_t tag[ITTAGE_TABLES];
+	/* ITTAGE_TABLES when there is no hit. */
+	size_t provider;
+};
+
+static uint32_t fold(uint64_t h, size_t len, size_t width)
+{
+	if (len < 64)
+		h &= ((uint64_t)1 << len) - 1;
+	uint32_t f = 0;
+	for (; h; h >>= width)
+		f ^= h & ((1u << width) - 1);
+	return f;
+}
+
+static void lookup(const struct ittage *it, const struct bpred_hist *hist, word_u pc, struct lookup *l)
+{
+	const uint32_t p = pc.u >> 2;
+	const uint64_t h = hist->recent;
+	l->provider = ITTAGE_TABLES;
+	for (size_t i = 0; i < ITTAGE_TABLES; i++) {
+		l->idx[i] = (p ^ (p >> ITTAGE_INDEX_BITS) ^ fold(h, hist_len[i], ITTAGE_INDEX_BITS))
+			& (ITTAGE_TABLE_SIZE - 1);
+		l->tag[i] = (p ^ (fold(h, hist_len[i], tag_bits[i] - 1) << 1))
+			& ((1u << tag_bits[i]) - 1);
+		/* Tag 0 marks an empty entry. */
+		l->tag[i] |= !l->tag[i];
+	}
+	for (size_t i = ITTAGE_TABLES; i-- > 0;) {
+		if (it->table[i][l->idx[i]].tag == l->tag[i]) {
+			l->provider = i;
+			break;
+		}
+	}
+}
+
+struct ittage *ittage_create(void)
+{
+	struct ittage *it = malloc(sizeof(*it));
+	assert(it);
+	ittage_clear(it);
+	return it;
+}
+
+void ittage_clear(struct ittage *it)
+{
+	memset(it, 0, sizeof(*it));
+	it->alloc_seed = 1;
+}
+
+bool ittage_predict(const struct ittage *it, const struct bpred_hist *hist, word_u pc, word_u *target)
+{
+	struct lookup l;
+	lookup(it, hist, pc, &l);
+	if (l.provider == ITTAGE_TABLES)
+		return false;
+	*target = it->table[l.provider][l.idx[l.provider]].target;
+	return true;
+}
+
+static void allocate(struct ittage *it, const struct lookup *l, word_u target, struct stats *stats)
+{
+	const size_t first = l->provider == ITTAGE_TABLES ? 0 : l->provider + 1;
+	if (first >= ITTAGE_TABLES)
+		return;
+	/* Spread allocations over the longer tables, as in TAGE. */
+	it->alloc_seed = it->alloc_seed * 1103515245u + 12345u;
+	bool skip = (it->alloc_seed >> 16) & 1;
+	for (size_t i = first; i < ITTAGE_TABLES; i++) {
+		struct ittage_entry *e = &it->table[i][l->idx[i]];
+		if (e->u)
+			continue;
+		if (skip && i + 1 < ITTAGE_TABLES && !it->table[i + 1][l->idx[i + 1]].u) {
+			skip = 0;
+			continue;
+		}
+		*e = (struct ittage_entry) {
+			.tag = l->tag[i],
+			.target = target,
+		};
+		stats->ittage_alloc++;
+		return;
+	}
+	for (size_t i = first; i < ITTAGE_TABLES; i++)
+		it->table[i][l->idx[i]].u--;
+	stats->ittage_alloc_fail++;
+}
+
+void ittage_update(struct ittage *it, const struct bpred_hist *hist, word_u pc,
+	word_u target, bool mispredicted, struct stats *stats)
+{
+	struct lookup l;
+	lookup(it, hist, pc, &l);
+
+	if (l.provider != ITTAGE_TABLES) {
+		struct ittage_entry *e = &it->table[l.provider][l.idx[l.provider]];
+		tracei("[ITTAGE] %x to %x, provider %lu had %x\n", pc.u, target.u, l.provider, e->target.u);
+		if (e->target.u == target.u) {
+			e->ctr += e->ctr < CTR_MAX;
+			e->u += e->u < U_MAX;
+		} else if (e->ctr) {
+			e->ctr--;
+			e->u -= e->u > 0;
+		} else {
+			/* Out of confidence: this path now goes here. */
+			e->target = target;
+		}
+	}
+	if (mispredicted)
+		allocate(it, &l, target, stats);
+}
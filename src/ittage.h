@@ -0,0 +1,37 @@
+/* ITTAGE indirect target predictor, for JALRs that aren't returns.
+ * Tagged tables indexed with the conditional branch history, each entry
+ * holding one target, so a site can have a target per path to it. The
+ * BTAC stands in for the untagged base table. */
+#pragma once
+
+#include <stdint.h>
+
+#include "bpred.h"
+
+struct stats;
+
+struct ittage_entry {
+	uint16_t tag;
+	/* Confidence in target. */
+	uint8_t ctr;
+	uint8_t u;
+	word_u target;
+};
+
+/* One copy per simulation, like the conditional predictors. */
+struct ittage {
+	struct ittage_entry table[ITTAGE_TABLES][ITTAGE_TABLE_SIZE];
+	uint32_t alloc_seed;
+};
+
+struct ittage *ittage_create(void);
+void ittage_clear(struct ittage *it);
+
+/* False if no table has an entry for pc with this history. */
+bool ittage_predict(const struct ittage *it, const struct bpred_hist *hist, word_u pc, word_u *target);
+
+/* Train at retire with the history the JALR was decoded with.
+ * New entries are only allocated when the JALR went somewhere other
+ * than where fetch was sent. */
+void ittage_update(struct ittage *it, const struct bpred_hist *hist, word_u pc,
+	word_u target, bool mispredicted, struct stats *stats);
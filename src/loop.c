@@ -0,0 +1,111 @@
+#include "loop.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+enum {
+	CONF_MAX = 3,
+	AGE_MAX = 7,
+};
+
+static struct loop_entry *loop_find(struct loop_pred *lp, word_u pc)
+{
+	const uint32_t p = pc.u / 4;
+	struct loop_entry *e = &lp->table[p & LOOP_INDEX_MASK];
+	/* Tag 0 is an empty entry. */
+	const uint16_t tag = (p / LOOP_SIZE) | 0x8000;
+	return e->tag == tag ? e : NULL;
+}
+
+static uint16_t loop_spec(const struct loop_pred *lp, const struct loop_entry *e)
+{
+	return e->epoch == lp->epoch ? e->spec_iter : e->iter;
+}
+
+struct loop_pred *loop_create(void)
+{
+	struct loop_pred *lp = malloc(sizeof(*lp));
+	assert(lp);
+	loop_clear(lp);
+	return lp;
+}
+
+void loop_clear(struct loop_pred *lp)
+{
+	memset(lp, 0, sizeof(*lp));
+}
+
+void loop_flush(struct loop_pred *lp)
+{
+	lp->epoch++;
+}
+
+bool loop_predict(struct loop_pred *lp, word_u pc, bool *taken)
+{
+	const struct loop_entry *e = loop_find(lp, pc);
+	if (!e || e->conf < CONF_MAX)
+		return false;
+	*taken = loop_spec(lp, e) < e->trip;
+	return true;
+}
+
+void loop_spec_update(struct loop_pred *lp, word_u pc, bool taken)
+{
+	struct loop_entry *e = loop_find(lp, pc);
+	if (!e)
+		return;
+	const uint16_t spec = loop_spec(lp, e);
+	e->spec_iter = taken ? spec + (spec != UINT16_MAX) : 0;
+	e->epoch = lp->epoch;
+}
+
+void loop_update(struct loop_pred *lp, word_u pc, bool backward, bool taken, bool mispredicted)
+{
+	struct loop_entry *e = loop_find(lp, pc);
+	if (!e) {
+		/* A backward branch falling through when we didn't expect it
+		 * might be a loop exit. Start counting from the next pass. */
+		if (!backward || taken || !mispredicted)
+			return;
+		const uint32_t p = pc.u / 4;
+		e = &lp->table[p & LOOP_INDEX_MASK];
+		if (e->age) {
+			e->age--;
+			return;
+		}
+		tracei("[loop] %x allocated\n", pc.u);
+		*e = (struct loop_entry) {
+			.tag = (p / LOOP_SIZE) | 0x8000,
+			.age = AGE_MAX,
+			.epoch = lp->epoch - 1,
+		};
+		return;
+	}
+
+	if (taken) {
+		if (e->iter != UINT16_MAX)
+			e->iter++;
+		/* Ran past the exit we learned. */
+		if (e->trip && e->iter > e->trip) {
+			e->trip = 0;
+			e->conf = 0;
+		}
+		return;
+	}
+
+	if (e->iter == e->trip) {
+		if (e->conf < CONF_MAX)
+			e->conf++;
+		if (e->age < AGE_MAX)
+			e->age++;
+	} else {
+		tracei("[loop] %x trip %u, was %u\n", pc.u, e->iter, e->trip);
+		e->trip = e->iter;
+		e->conf = 0;
+		if (e->age)
+			e->age--;
+	}
+	e->iter = 0;
+}
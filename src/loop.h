@@ -0,0 +1,46 @@
+/* Loop predictor.
+ * Learns backward conditional branches which are taken a fixed number of
+ * times and then fall through, and once the count has repeated enough
+ * overrides the direction predictor. */
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+#include "word.h"
+
+struct stats;
+
+struct loop_entry {
+	uint16_t tag;
+	/* Taken count before the exit, 0 while unknown. */
+	uint16_t trip;
+	/* Taken so far this time round, at retire. */
+	uint16_t iter;
+	/* And at decode, valid while epoch matches the table's. */
+	uint16_t spec_iter;
+	uint32_t epoch;
+	/* Times trip has repeated. */
+	uint8_t conf;
+	/* Replacement: allocating over a live entry wears this down first. */
+	uint8_t age;
+};
+
+/* One copy per simulation; decode and retire each keep their own count. */
+struct loop_pred {
+	struct loop_entry table[LOOP_SIZE];
+	/* Bumped on flush: nothing is in flight then, so every speculative
+	 * count is back to its retired count. */
+	uint32_t epoch;
+};
+
+struct loop_pred *loop_create(void);
+void loop_clear(struct loop_pred *lp);
+void loop_flush(struct loop_pred *lp);
+
+/* False unless pc is a confident loop, else its direction in taken. */
+bool loop_predict(struct loop_pred *lp, word_u pc, bool *taken);
+/* At decode, with the direction finally predicted. */
+void loop_spec_update(struct loop_pred *lp, word_u pc, bool taken);
+/* At retire. mispredicted is for the prediction decode went with. */
+void loop_update(struct loop_pred *lp, word_u pc, bool backward, bool taken, bool mispredicted);
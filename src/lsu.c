@@ -4,7 +4,6 @@
 
 #include "config.h"
 #include "decode.h"
-#include "debugger.h"
 #include "util.h"
 
 word_u instr_lsu_op(uint32_t opcode, uint32_t funct3)
@@ -40,14 +39,10 @@ word_u memory_op(uint8_t *mem, enum lsu_op op, word_u addr, word_u data_in, bool
 	word_u out = { .u = 0 };
 	addr.u &= ~1u;
 
+	assert(exception);
 	if (addr.u > MEM_SIZE) {
-		if (exception) {
-			*exception = 1;
-			printf("[lsu] Warn invalid mem access, perhaps speculative.\n");
-		} else {
-			printf("[lsu] Invalid mem access to %x\n", addr.u);
-			debugger_pause = 1;
-		}
+		*exception = 1;
+		printf("[lsu] Warn invalid mem access to %x, perhaps speculative.\n", addr.u);
 		return out;
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 /* LSU */
+#include "prf.h"
 #include "word.h"
 
 enum lsu_op {
@@ -29,6 +30,9 @@ typedef struct {
 	enum lsu_op op;
 	word_u addr;
 	size_t rob_id;
+	preg_t dest;
+	size_t stq_pos;
+	size_t stq_dep;
 	size_t clk_start;
 	word_u data_in;
 
@@ -38,5 +42,6 @@ typedef struct {
 } lsu_t;
 
 word_u instr_lsu_op(uint32_t opcode, uint32_t funct3);
+/* An access outside memory sets *exception and does nothing. */
 word_u memory_op(uint8_t *mem, enum lsu_op op, word_u addr, word_u data_in, bool *exception);
 
@@ -0,0 +1,89 @@
+#include "mdu.h"
+
+#include <stdarg.h>
+
+#include "decode.h"
+#include "util.h"
+
+bool instr_is_mdu(word_u instr)
+{
+	return instr_opcode(instr).u == OPC_REG_REG
+		&& instr_funct7(instr).u == MDU_FUNCT7;
+}
+
+enum mdu_op instr_mdu_op(word_u instr)
+{
+	assert(instr_is_mdu(instr));
+	return MDU_OP_SET | instr_funct3(instr).u;
+}
+
+enum fu_class mdu_op_class(enum mdu_op op)
+{
+	return op < MDU_OP_DIV ? FU_MUL : FU_DIV;
+}
+
+static uint32_t magnitude(word_u v, bool is_signed)
+{
+	return is_signed && v.s < 0 ? -v.u : v.u;
+}
+
+size_t mdu_latency(const mdu_t *mdu)
+{
+	const enum fu_class c = mdu_op_class(mdu->op);
+	if (c == FU_MUL)
+		return fu_timing[c].latency;
+
+	const bool is_signed = mdu->op == MDU_OP_DIV || mdu->op == MDU_OP_REM;
+	const uint32_t a = magnitude(mdu->op1, is_signed);
+	const uint32_t b = magnitude(mdu->op2, is_signed);
+	size_t bits = 0;
+	if (b && a >= b)
+		bits = __builtin_clz(b) - __builtin_clz(a) + 1;
+	return fu_timing[c].latency + bits;
+}
+
+word_u mdu_result(const mdu_t *mdu)
+{
+	const word_u a = mdu->op1, b = mdu->op2;
+	switch (mdu->op) {
+	case MDU_OP_MUL:
+		tracei("[ex] MDU: %d * %d\n", a.s, b.s);
+		return (word_u) { .u = a.u * b.u };
+	case MDU_OP_MULH:
+		tracei("[ex] MDU: %d * %d (high)\n", a.s, b.s);
+		return (word_u) { .u = ((int64_t)a.s * (int64_t)b.s) >> 32 };
+	case MDU_OP_MULHSU:
+		tracei("[ex] MDU: %d * %u (high)\n", a.s, b.u);
+		return (word_u) { .u = ((int64_t)a.s * (int64_t)(uint64_t)b.u) >> 32 };
+	case MDU_OP_MULHU:
+		tracei("[ex] MDU: %u * %u (high)\n", a.u, b.u);
+		return (word_u) { .u = ((uint64_t)a.u * (uint64_t)b.u) >> 32 };
+	/* Division by zero and overflow give what the spec says, no trap. */
+	case MDU_OP_DIV:
+		tracei("[ex] MDU: %d / %d\n", a.s, b.s);
+		if (!b.u)
+			return (word_u) { .s = -1 };
+		if (a.u == 0x80000000 && b.s == -1)
+			return a;
+		return (word_u) { .s = a.s / b.s };
+	case MDU_OP_DIVU:
+		tracei("[ex] MDU: %u / %u\n", a.u, b.u);
+		if (!b.u)
+			return (word_u) { .u = 0xFFffFFff };
+		return (word_u) { .u = a.u / b.u };
+	case MDU_OP_REM:
+		tracei("[ex] MDU: %d %% %d\n", a.s, b.s);
+		if (!b.u)
+			return a;
+		if (a.u == 0x80000000 && b.s == -1)
+			return (word_u) { .u = 0 };
+		return (word_u) { .s = a.s % b.s };
+	case MDU_OP_REMU:
+		tracei("[ex] MDU: %u %% %u\n", a.u, b.u);
+		if (!b.u)
+			return a;
+		return (word_u) { .u = a.u % b.u };
+	default:
+		assert(0);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "fu.h"
+#include "prf.h"
+#include "word.h"
+
+/* MDU - RV32M multiply and divide. */
+
+enum mdu_op {
+	/* funct3 | 0x200 */
+	MDU_OP_MUL	= 0x200,
+	MDU_OP_MULH	= 0x201,
+	MDU_OP_MULHSU	= 0x202,
+	MDU_OP_MULHU	= 0x203,
+	MDU_OP_DIV	= 0x204,
+	MDU_OP_DIVU	= 0x205,
+	MDU_OP_REM	= 0x206,
+	MDU_OP_REMU	= 0x207,
+
+	MDU_OP_SET = 0x200,
+};
+
+/* funct7 of OPC_REG_REG for RV32M. */
+#define MDU_FUNCT7 0x01
+
+typedef struct {
+	enum mdu_op op;
+	word_u op1, op2;
+	size_t rob_id;
+	preg_t dest;
+	size_t clk_start;
+} mdu_t;
+
+/* A multiply or divide rather than a plain register-register op. */
+bool instr_is_mdu(word_u instr);
+
+enum mdu_op instr_mdu_op(word_u instr);
+
+/* FU_MUL or FU_DIV. */
+enum fu_class mdu_op_class(enum mdu_op op);
+
+/* Cycles from issue to result. The divider is iterative and produces a
+ * quotient bit a cycle, skipping the leading ones it doesn't need. */
+size_t mdu_latency(const mdu_t *mdu);
+
+/* Return the result of an MDU operation. */
+word_u mdu_result(const mdu_t *mdu);
@@ -0,0 +1,127 @@
+#include "perceptron.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "stats.h"
+#include "util.h"
+
+/* History segment [seg[i - 1], seg[i]) feeds table i, table 0 is the PC only. */
+static const size_t seg[PERCEPTRON_TABLES] = {
+	0, 3, 6, 10, 14, 19, 24, 30, 37, 45, 54, 65, 78, 93, 110, 128,
+};
+
+_Static_assert(PERCEPTRON_TABLES == 16, "sum below is two vectors of eight");
+_Static_assert(BPRED_HIST_LEN >= 128, "history shorter than the last segment");
+
+enum {
+	W_MAX = 127,
+	W_MIN = -127,
+	THETA_CTR_MAX = 63,
+};
+
+typedef int16_t v8hi __attribute__((vector_size(16)));
+
+static void perceptron_clear(void *self)
+{
+	struct perceptron *p = self;
+	memset(p->w, 0, sizeof(p->w));
+	/* Threshold that works for this many tables, from the O-GEHL paper. */
+	p->theta = PERCEPTRON_TABLES * 2 + 14;
+	p->theta_ctr = 0;
+}
+
+static void indices(const struct bpred_hist *hist, word_u pc, size_t *idx)
+{
+	const uint32_t p = pc.u >> 2;
+	idx[0] = p & (PERCEPTRON_TABLE_SIZE - 1);
+	for (size_t i = 1; i < PERCEPTRON_TABLES; i++) {
+		uint32_t h = bpred_hist_range(hist, seg[i - 1], seg[i] - seg[i - 1]);
+		h ^= h >> PERCEPTRON_INDEX_BITS;
+		idx[i] = (p ^ (p >> i) ^ (h * 0x9e5u) ^ i) & (PERCEPTRON_TABLE_SIZE - 1);
+	}
+}
+
+static int output(const struct perceptron *p, const size_t *idx)
+{
+	union {
+		v8hi v[2];
+		int16_t e[PERCEPTRON_TABLES];
+	} w;
+	for (size_t i = 0; i < PERCEPTRON_TABLES; i++)
+		w.e[i] = p->w[i][idx[i]];
+
+	/* Lane-wise add, then fold the eight lanes in half three times. */
+	v8hi s = w.v[0] + w.v[1];
+	s += __builtin_shufflevector(s, s, 4, 5, 6, 7, 0, 1, 2, 3);
+	s += __builtin_shufflevector(s, s, 2, 3, 0, 1, 2, 3, 0, 1);
+	s += __builtin_shufflevector(s, s, 1, 0, 1, 0, 1, 0, 1, 0);
+	return s[0];
+}
+
+static enum bpred_dir perceptron_predict(const void *self, const struct bpred_hist *hist, word_u pc)
+{
+	size_t idx[PERCEPTRON_TABLES];
+	indices(hist, pc, idx);
+	return output(self, idx) >= 0 ? BPRED_TAKEN : BPRED_NOT_TAKEN;
+}
+
+static bool perceptron_resolve(void *self, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats)
+{
+	struct perceptron *p = self;
+	size_t idx[PERCEPTRON_TABLES];
+	indices(hist, pc, idx);
+	const int y = output(p, idx);
+	const bool pred = y >= 0;
+
+	if (pred == taken)
+		stats->perceptron_correct++;
+	else
+		stats->perceptron_incorrect++;
+	tracei("[perceptron] %x %staken, output %d theta %d\n", pc.u, taken ? "" : "not ", y, p->theta);
+
+	if (pred == taken && abs(y) > p->theta)
+		return pred;
+
+	stats->perceptron_trained++;
+	for (size_t i = 0; i < PERCEPTRON_TABLES; i++) {
+		int8_t *w = &p->w[i][idx[i]];
+		if (taken && *w < W_MAX)
+			(*w)++;
+		else if (!taken && *w > W_MIN)
+			(*w)--;
+	}
+
+	/* Raise the threshold when mispredicting, lower it when training
+	 * only because of it. */
+	if (pred != taken) {
+		if (++p->theta_ctr >= THETA_CTR_MAX) {
+			p->theta++;
+			p->theta_ctr = 0;
+		}
+	} else {
+		if (--p->theta_ctr <= -THETA_CTR_MAX) {
+			p->theta--;
+			p->theta_ctr = 0;
+		}
+	}
+
+	return output(p, idx) >= 0;
+}
+
+static void *perceptron_create(void)
+{
+	struct perceptron *p = malloc(sizeof(*p));
+	if (p)
+		perceptron_clear(p);
+	return p;
+}
+
+const struct bpred_ops perceptron_ops = {
+	.name = "perceptron",
+	.create = perceptron_create,
+	.clear = perceptron_clear,
+	.predict = perceptron_predict,
+	.spec_update = bpred_hist_shift,
+	.resolve = perceptron_resolve,
+};
@@ -0,0 +1,17 @@
+/* Hashed perceptron conditional branch predictor */
+#pragma once
+
+#include <stdint.h>
+
+#include "bpred.h"
+
+/* One weight table for the PC alone, then one per segment of global
+ * history, each indexed by a hash of the PC and that segment. */
+struct perceptron {
+	int8_t w[PERCEPTRON_TABLES][PERCEPTRON_TABLE_SIZE];
+	/* Keep training while the output is below this, adapted at run time. */
+	int theta;
+	int theta_ctr;
+};
+
+extern const struct bpred_ops perceptron_ops;
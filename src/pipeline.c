@@ -13,80 +13,133 @@ bool is_link_reg(uint8_t reg)
 	return (reg == REG_RA || reg == REG_T0);
 }
 
-void pipeline_flush(state_t *next)
+/* Forget whatever fetch and decode were up to. */
+static void frontend_flush(state_t *next)
 {
-	for (size_t i = 0; i < REG_COUNT; i++)
-		next->arf[i].rob_id = 0;
-
-	next->pc_last =
 	next->pc_fetch =
+	next->pc_exec_bru =
 	next->pc_rob_mispredict =
 	next->pc_decode_predict = (word_u){ 0 };
-	assert(next->fetch_wait_rob_mispredict);
-	next->decode_is_clear = 0;
+	next->fetch_wait_jalr_bru = 0;
 	next->decode_drop_next = 0;
 
-	memset(next->fetch_window, 0, sizeof(next->fetch_window));
-	memset(next->held_window, 0, sizeof(next->held_window));
+	fetch_flush(&next->ftq, &next->fetch_buf);
+}
+
+void pipeline_flush(const state_t *curr, state_t *next)
+{
+	prf_flush(next->prf);
+
+	assert(next->fetch_wait_rob_mispredict);
+	frontend_flush(next);
 
-	next->ras = (ras_t) { 0 };
+	loop_flush(next->loop);
 
 	memset(next->rss, 0, sizeof(next->rss));
 	memset(next->ldb, 0, sizeof(next->ldb));
-	memset(next->alus, 0, sizeof(next->alus));
+	memset(next->fu_next_issue, 0, sizeof(next->fu_next_issue));
+	next->fu_events.count = 0;
 	memset(next->lsus, 0, sizeof(next->lsus));
 	memset(next->brus, 0, sizeof(next->brus));
 
-	memset(next->rob, 0, sizeof(next->rob));
+	for (size_t i = curr->rob_tail; i != next->rob_head; i = (i + 1) & ROB_INDEX_MASK)
+		next->rob[i] = (rob_t){ 0 };
+	next->rob_ready = next->rob_bypassed = next->rob_loaded = next->rob_cond = (rob_mask_t){ 0 };
 	next->rob_head = next->rob_tail = 0;
-	next->ldb_head = next->ldb_tail = 0;
+	next->stq = (struct stq){ 0 };
+	storeset_flush(&next->storeset);
 	next->cdb = (struct cdb){ 0 };
 }
 
-bool addrs_may_overlap(word_u this, word_u other)
+void branch_recover(const state_t *curr, state_t *next, size_t rob_id, word_u act)
 {
-	assert(this.u);
-	return (other.u == 0 && !opt_nostorechk)
-		|| this.u == other.u
-	    	|| this.u == other.u + 1
-	       	|| this.u == other.u + 2
-	       	|| this.u == other.u + 3
-	       	|| this.u + 1 == other.u
-	       	|| this.u + 2 == other.u
-	       	|| this.u + 3 == other.u;
-}
+	rob_t *const branch = &next->rob[rob_id - 1];
+	assert(branch->id == rob_id && branch->type == ROB_INSTR_BRANCH);
+
+	/* A JALR's link write goes with it. */
+	size_t last = rob_id - 1;
+	const size_t link = (last + 1) & ROB_INDEX_MASK;
+	if (link != next->rob_head && next->rob[link].type == ROB_INSTR_REGISTER
+			&& next->rob[link].pc.u == branch->pc.u)
+		last = link;
+	/* Everything allocated after this is younger, including what decode
+	 * did this cycle. */
+	const size_t keep = rob_age(curr, last + 1);
+#define YOUNGER(id) ((id) && rob_age(curr, (id)) > keep)
+
+	size_t squashed = 0;
+	for (size_t i = (last + 1) & ROB_INDEX_MASK; i != next->rob_head; i = (i + 1) & ROB_INDEX_MASK) {
+		if (next->rob[i].aliased)
+			prf_unalias(next->prf, next->rob[i].preg);
+		rob_free(next, i);
+		squashed++;
+	}
+	next->rob_head = (last + 1) & ROB_INDEX_MASK;
+	tracei("[bru] mispredict on %lu, squash %lu younger\n", rob_id, squashed);
 
-bool rob_earlier_store_overlaps(const state_t *curr, const lsu_t *lsu, word_u *val, bool *set_val, bool *dbg_wait_val)
-{
-	bool flag = false;
-	*set_val = 0;
-	val->u = 0;
-	FOR_INDEX_ROB(curr, i) {
-		if (curr->rob[i].id == lsu->rob_id) {
-			return flag;
+	for (size_t i = 0; i < RS_COUNT; i++) {
+		if (next->rss[i].busy && YOUNGER(next->rss[i].rob_id)) {
+			next->rss[i] = (rs_t){ 0 };
+			next->rs_ready &= ~RS_BIT(i);
 		}
-		if (
-			curr->rob[i].type == ROB_INSTR_STORE &&
-			addrs_may_overlap(lsu->addr, curr->rob[i].data.reg.dest)
-		) {
-			flag = 1;
-			if (curr->rob[i].data.reg.dest.u == lsu->addr.u &&
-				curr->rob[i].store_op & lsu->op & LSU_WIDTH_MASK
-			) {
-				*dbg_wait_val = 1;
-				if (curr->rob[i].ready) {
-					*set_val = 1;
-					*val = curr->rob[i].data.reg.val;
-				} else {
-					*set_val = 0;
-				}
-			} else {
-				*dbg_wait_val = 0;
-				*set_val = 0;
-			}
+	}
+	for (size_t i = 0; i < LDB_SIZE; i++)
+		if (next->ldb[i].busy && YOUNGER(next->ldb[i].rob_id))
+			next->ldb[i] = (rs_t){ 0 };
+	size_t kept = 0;
+	for (size_t i = 0; i < next->fu_events.count; i++)
+		if (!YOUNGER(next->fu_events.ev[i].rob_id))
+			next->fu_events.ev[kept++] = next->fu_events.ev[i];
+	next->fu_events.count = kept;
+	for (size_t i = 0; i < LSU_COUNT; i++)
+		if (YOUNGER(next->lsus[i].rob_id))
+			next->lsus[i] = (lsu_t){ 0 };
+	for (size_t i = 0; i < BRU_COUNT; i++)
+		if (YOUNGER(next->brus[i].rob_id))
+			next->brus[i] = (bru_t){ 0 };
+	for (size_t i = 0; i < CDB_WIDTH; i++)
+		if (YOUNGER(next->cdb.buffer[i].rob_id))
+			next->cdb.buffer[i] = (cdb_entry){ 0 };
+
+	/* Stores are in age order, so the younger ones are all at the head. */
+	size_t pos = next->stq.tail;
+	while (pos != next->stq.head && !YOUNGER(next->stq.buffer[pos].rob_id))
+		pos = (pos + 1) & STQ_INDEX_MASK;
+	for (size_t i = pos; i != next->stq.head; i = (i + 1) & STQ_INDEX_MASK)
+		storeset_store_retired(&next->storeset, next->stq.buffer[i].pc, i);
+	stq_squash(&next->stq, pos);
+
+#undef YOUNGER
+	prf_restore(next->prf, &branch->branch_ctrl.rename);
+
+	if (b_test(branch->branch_ctrl.change_bht))
+		bpred_recover(next->bpred, &next->bpred_hist, &branch->branch_ctrl.hist,
+			branch->pc, !b_test(branch->branch_ctrl.pred_taken));
+	else
+		next->bpred_hist = branch->branch_ctrl.hist;
+	if (opt_ras_flush)
+		next->ras = (ras_t){ 0 };
+	else
+		ras_restore(&next->ras, &branch->branch_ctrl.ras);
+	branch->branch_ctrl.recovered = 1;
+
+	/* Retired counts are behind by the branches still in flight. */
+	loop_flush(next->loop);
+	if (feature_loop) {
+		FOR_ROB_MASK(&next->rob_cond, i, curr->rob_tail, next->rob_head) {
+			const rob_t *rob = &next->rob[i];
+			loop_spec_update(next->loop, rob->pc,
+				b_test(rob->branch_ctrl.pred_taken) != rob->branch_ctrl.recovered);
 		}
 	}
-	assert(0);
+
+	frontend_flush(next);
+	next->fetch_wait_rob_mispredict = 1;
+	next->pc_rob_mispredict = act;
+
+	next->stats.flushed += squashed;
+	next->stats.early_recover++;
+	next->stats.early_squashed += squashed;
 }
 
 void rob_alloc_only(const state_t *curr, state_t *next, rob_t *rob, enum rob_type type, word_u pc)
@@ -97,8 +150,11 @@ void rob_alloc_only(const state_t *curr, state_t *next, rob_t *rob, enum rob_typ
 	rob->id = next->rob_head + 1;
 	rob->type = type;
 	rob->pc = pc;
-	if (type == ROB_INSTR_BRANCH)
-		rob->branch_ctrl.global_history = curr->global_branch_history;
+	if (type == ROB_INSTR_BRANCH) {
+		rob->branch_ctrl.hist = next->bpred_hist;
+		rob->branch_ctrl.ras = ras_checkpoint(&next->ras);
+		rob->branch_ctrl.rename = prf_checkpoint(next->prf);
+	}
 
 	if (next->rob_head == 0) {
 		//printf("abcde %lu %lu %s\n", next->rob_head, rob->id, rob_type_str(rob->type));
@@ -121,6 +177,8 @@ void rs_alloc_only(state_t *next, rs_t *rs, enum rs_type type, word_u pc, word_u
 	rs->pc = pc;
 	rs->op = op;
 	rs->type = type;
+	if (type != RS_LOAD)
+		rs_select_insert(&next->rs_select, rs - next->rss, type);
 }
 
 void rs_rob_alloc(const state_t *curr, state_t *next, rs_t *rs, rob_t *rob, enum rob_type rob_type, enum rs_type rs_type, word_u pc, word_u op)
@@ -131,25 +189,66 @@ void rs_rob_alloc(const state_t *curr, state_t *next, rs_t *rs, rob_t *rob, enum
 	rs->rob_id = rob->id;
 }
 
-void rob_rd(state_t *next, rob_t *rob, uint8_t rd)
+preg_t rob_rd(state_t *next, rob_t *rob, uint8_t rd)
 {
 	assert(rd);
 	assert(rob);
 	assert(rob->id);
 	assert(rd && rd < REG_COUNT);
 
-	next->arf[rd].rob_id = rob->id;
+	rob->preg = prf_rename(next->prf, rd, &rob->old_preg);
 
 	switch (rob->type) {
 	case ROB_INSTR_REGISTER:
 		rob->data.reg.dest.u = rd;
 		break;
 	case ROB_INSTR_DEBUG:
-		rob->data.debug.operand.u = rd;
+		/* Always REG_T3. */
 		break;
 	default:
 		assert(0);
 	}
+	return rob->preg;
+}
+
+void rob_rd_ready(state_t *next, rob_t *rob, word_u val)
+{
+	assert(rob->type == ROB_INSTR_REGISTER && rob->preg);
+	prf_write(next->prf, rob->preg, val);
+	rob_set_ready(next, rob);
+}
+
+void rob_rd_alias(state_t *next, rob_t *rob, uint8_t rd, uint8_t rs)
+{
+	assert(rob->type == ROB_INSTR_REGISTER);
+	rob->preg = prf_alias(next->prf, rd, rs, &rob->old_preg);
+	rob->data.reg.dest.u = rd;
+	rob->aliased = 1;
+	rob_set_ready(next, rob);
+}
+
+void rob_set_ready(state_t *next, const rob_t *rob)
+{
+	assert(rob->id);
+	assert(!rob_mask_test(&next->rob_ready, rob->id - 1));
+	rob_mask_set(&next->rob_ready, rob->id - 1);
+}
+
+void rob_ready(state_t *next, rob_t *rob, word_u val)
+{
+	assert(rob->type == ROB_INSTR_BRANCH);
+	assert(!rob->data.brt.act.u);
+	rob->data.brt.act = val;
+	rob_set_ready(next, rob);
+}
+
+void rob_free(state_t *next, size_t i)
+{
+	next->rob[i] = (rob_t){ 0 };
+	rob_mask_clear(&next->rob_ready, i);
+	rob_mask_clear(&next->rob_bypassed, i);
+	rob_mask_clear(&next->rob_loaded, i);
+	rob_mask_clear(&next->rob_cond, i);
 }
 
 rob_t *rob_find_free(const state_t *curr, state_t *next)
@@ -164,66 +263,135 @@ rob_t *rob_find_free(const state_t *curr, state_t *next)
 
 rs_t *ldb_find_free(const state_t *curr, state_t *next)
 {
-	size_t ni = (next->ldb_head + 1) & LDB_INDEX_MASK;
-	rs_t *ldb = &next->ldb[next->ldb_head];
-	if (ni == curr->ldb_tail || ldb->busy) {
-		return NULL;
-	} else {
-		assert(!ldb->busy);
-		return ldb;
+	for (size_t i = 0; i < LDB_SIZE; i++) {
+		if (!curr->ldb[i].busy && !next->ldb[i].busy)
+			return &next->ldb[i];
 	}
+	return NULL;
 }
 
-void ldb_alloc(const state_t *curr, state_t *next, rs_t *new_ldb)
+/* Position of a ROB entry counting from the oldest one. */
+size_t rob_age(const state_t *curr, size_t rob_id)
 {
-	size_t ni = (next->ldb_head + 1) & LDB_INDEX_MASK;
-	rs_t *ldb = &next->ldb[next->ldb_head];
-	assert(ldb == new_ldb);
-	assert(!ldb->busy);
-	assert(ni != curr->ldb_tail);
-	next->ldb_head = ni;
+	assert(rob_id);
+	return (rob_id - 1 - curr->rob_tail) & ROB_INDEX_MASK;
 }
 
 const rs_t *rs_waiting_and_free(const state_t *curr, state_t *next, enum rs_type type)
 {
-	const rs_t *best = NULL;
-	rs_t *best_next = NULL;
-	for (size_t i = 0; i < RS_COUNT; i++) {
-		if (
-			curr->rss[i].busy && curr->rss[i].qj == 0
-			&& curr->rss[i].qk == 0
-			&& curr->rss[i].type == type
-		       	&& next->rss[i].busy
-			&& (!best || curr->rss[i].clk < best->clk)
-		) {
-			assert(type == RS_BR || curr->rss[i].rob_id);
-			best = &curr->rss[i];
-			best_next = &next->rss[i];
+	const rs_mask_t cand = next->rs_ready & next->rs_select.type[type];
+	size_t i = rs_select_oldest(&next->rs_select, cand);
+	if (i == RS_COUNT)
+		return NULL;
+	if (cand & next->rs_urgent) {
+		const size_t u = rs_select_oldest(&next->rs_select, cand & next->rs_urgent);
+		if (u != i)
+			next->stats.issue_promoted++;
+		i = u;
+	}
+	const rs_t *best = &curr->rss[i];
+	assert(best->busy && !best->qj && !best->qk && best->type == type);
+	assert(next->rss[i].busy);
+	assert(type == RS_BR || best->rob_id);
+	next->rss[i] = (rs_t) { 0 };
+	next->rs_ready &= ~RS_BIT(i);
+	return best;
+}
+
+void rs_select_urgent(const state_t *curr, state_t *next)
+{
+	preg_t want[2 * (RS_COUNT + LDB_SIZE)];
+	size_t n = 0;
+	if (opt_issue == ISSUE_BRANCH_FIRST) {
+		for (size_t i = 0; i < RS_COUNT; i++) {
+			const rs_t *rs = &curr->rss[i];
+			if (!rs->busy || rs->type != RS_BR)
+				continue;
+			if (rs->qj)
+				want[n++] = rs->qj;
+			if (rs->qk)
+				want[n++] = rs->qk;
+		}
+	} else if (opt_issue == ISSUE_LOAD_FIRST) {
+		for (size_t i = 0; i < LDB_SIZE; i++) {
+			const rs_t *ldb = &curr->ldb[i];
+			if (!ldb->busy)
+				continue;
+			if (ldb->qj)
+				want[n++] = ldb->qj;
+			if (ldb->qk)
+				want[n++] = ldb->qk;
 		}
 	}
-	if (best) {
-		*best_next = (rs_t) { 0 };
+	if (!n)
+		return;
+	const rs_mask_t alus = next->rs_ready & next->rs_select.type[RS_ALU];
+	for (rs_mask_t m = alus; m; m &= m - 1) {
+		const size_t i = __builtin_ctzll(m);
+		for (size_t k = 0; k < n; k++) {
+			if (curr->rss[i].dest == want[k]) {
+				next->rs_urgent |= RS_BIT(i);
+				break;
+			}
+		}
 	}
-	return best;
 }
 
-const rs_t *ldb_next_and_free(const state_t *curr, state_t *next)
+/* Which stores with unknown addresses a load has to wait for. */
+stq_mask_t load_wait_unknown(size_t stq_dep)
 {
-	rs_t *new_tail = &next->ldb[next->ldb_tail];
-	const rs_t *curr_tail = &curr->ldb[next->ldb_tail];
-	if (
-		curr->ldb_head == next->ldb_tail
-		|| curr_tail->qj || curr_tail->qk
-	) {
-		return NULL;
-	} else {
-		assert(curr_tail->busy);
-		if (!new_tail->busy)
-			return NULL;
-		*new_tail = (rs_t) { 0 };
-		next->ldb_tail = (next->ldb_tail + 1) & LDB_INDEX_MASK;
-		return curr_tail;
+	if (opt_nostorechk)
+		return 0;
+	else if (!feature_storeset)
+		return ~(stq_mask_t)0;
+	else if (stq_dep != STQ_SIZE)
+		return STQ_BIT(stq_dep);
+	else
+		return 0;
+}
+
+/* Loads are issued oldest first. A load waiting on older stores keeps its
+ * LSU, so only the oldest loads may go before their stores are sorted out,
+ * a load that overtakes an older one must be clear of the store queue.
+ * load_order_check() keeps loads to the same bytes consistent. */
+size_t ldb_next_and_free(const state_t *curr, state_t *next, const rs_t **issue, size_t max)
+{
+	size_t order[LDB_SIZE], ages[LDB_SIZE], n = 0;
+	for (size_t i = 0; i < LDB_SIZE; i++) {
+		if (!curr->ldb[i].busy || !next->ldb[i].busy)
+			continue;
+		const size_t age = rob_age(curr, curr->ldb[i].rob_id);
+		size_t j = n++;
+		for (; j && ages[j - 1] > age; j--) {
+			order[j] = order[j - 1];
+			ages[j] = ages[j - 1];
+		}
+		order[j] = i;
+		ages[j] = age;
 	}
+
+	size_t cnt = 0;
+	bool skipped = false;
+	for (size_t k = 0; k < n && cnt < max; k++) {
+		const rs_t *ldb = &curr->ldb[order[k]];
+		if (ldb->qj || ldb->qk) {
+			if (!feature_ooo_loads)
+				break;
+			skipped = true;
+			continue;
+		}
+		if (skipped) {
+			struct stq_fwd fwd;
+			stq_forward(&curr->stq, ldb->stq_id, ldb->op.u, ldb->addr,
+				load_wait_unknown(ldb->stq_dep), &fwd);
+			if (fwd.wait || (fwd.mask && !feature_store_forward))
+				continue;
+			next->stats.ldb_ooo_issue++;
+		}
+		issue[cnt++] = ldb;
+		next->ldb[order[k]] = (rs_t) { 0 };
+	}
+	return cnt;
 }
 
 void rs_find_free(const state_t *curr, state_t *next, const rs_t **rs_curr, rs_t **rs_next)
@@ -238,73 +406,75 @@ void rs_find_free(const state_t *curr, state_t *next, const rs_t **rs_curr, rs_t
 	*rs_curr = *rs_next = NULL;
 }
 
-void rs_set_rsrc1(rs_t *rs, uint8_t rsrc1, state_t *next)
+/* Value of a source register, or the tag to wait for. */
+static void rs_set_src(const state_t *next, uint8_t r, word_u *v, size_t *q)
 {
-	if (rsrc1 == 0) {
-		rs->vj.u = 0;
-		rs->qj = 0;
-		return;
-	}
-
-	const reg_t *reg = &next->arf[rsrc1];
-	if (reg->rob_id) {
-		const rob_t *rob = &next->rob[reg->rob_id - 1];
-		assert(rob->type == ROB_INSTR_REGISTER ||
-			rob->type == ROB_INSTR_DEBUG);
-		if (rob->ready) {
-			rs->vj = rob_get_reg_val(rob);
-			rs->qj = 0;
-		} else {
-			rs->vj.u = 0xABABABAB;
-			rs->qj = reg->rob_id;
-		}
+	const preg_t p = next->prf->spec[r];
+	if (next->prf->ready[p]) {
+		*v = next->prf->val[p];
+		*q = 0;
 	} else {
-		rs->vj = next->arf[rsrc1].dat;
-		rs->qj = 0;
+		v->u = 0xABABABAB;
+		*q = p;
 	}
 }
 
-void rs_set_rsrc2(rs_t *rs, uint8_t rsrc2, state_t *next)
+void rs_set_rsrc1(rs_t *rs, uint8_t rsrc1, state_t *next)
 {
-	if (rsrc2 == 0) {
-		rs->vk.u = 0;
-		rs->qk = 0;
-		return;
-	}
+	rs_set_src(next, rsrc1, &rs->vj, &rs->qj);
+}
 
-	const reg_t *reg = &next->arf[rsrc2];
-	if (reg->rob_id) {
-		const rob_t *rob = &next->rob[reg->rob_id - 1];
-		assert(rob->type == ROB_INSTR_REGISTER ||
-			rob->type == ROB_INSTR_DEBUG);
-		if (rob->ready) {
-			rs->vk = rob_get_reg_val(rob);
-			rs->qk = 0;
-		} else {
-			rs->vk.u = 0xABABABAB;
-			rs->qk = reg->rob_id;
-		}
-	} else {
-		rs->vk = next->arf[rsrc2].dat;
-		rs->qk = 0;
-	}
+void rs_set_rsrc2(rs_t *rs, uint8_t rsrc2, state_t *next)
+{
+	rs_set_src(next, rsrc2, &rs->vk, &rs->qk);
 }
 
 #define IS_BRANCH(instr) ( instr_opcode(instr).u == OPC_JAL || instr_opcode(instr).u == OPC_JALR || instr_opcode(instr).u == OPC_BRANCH)
 
 
-void bht_btac_update(const state_t *curr, state_t *next, word_u pc, size_t global_history, bool taken, word_u taddr)
+void bht_btac_update(const state_t *curr, state_t *next, const rob_t *entry, bool taken, word_u taddr)
 {
 	if (!feature_branch_bht_btac || opt_nospec)
 		return;
 
-	uint8_t ctr = bht_update(&curr->bht, &next->bht, pc, global_history, taken);
+	const word_u pc = entry->pc;
+	const bool pred_taken = bpred_resolve(next->bpred, &entry->branch_ctrl.hist, pc, taken, &next->stats);
+
+	if (entry->branch_ctrl.loop != ROB_LOOP_NONE) {
+		const bool right = entry->data.brt.pred.u == entry->data.brt.act.u;
+		next->stats.loop_correct += right;
+		next->stats.loop_incorrect += !right;
+		if (entry->branch_ctrl.loop == ROB_LOOP_OVERRIDE) {
+			next->stats.loop_override++;
+			next->stats.loop_override_correct += right;
+		}
+	}
+	if (feature_loop)
+		loop_update(next->loop, pc, entry->branch_ctrl.backward, taken,
+			entry->data.brt.pred.u != entry->data.brt.act.u);
 
 	/* BTAC entries stored for predicted-taken branches only (Otherwise fetch just carries on anyway) */
-	if (taken && ctr > 1) {
-		btac_update(&next->btac, pc, taddr);
-	} else if (ctr < 2) {
-		btac_update(&next->btac, pc, (word_u){ .u = 0 });
+	if (taken && pred_taken) {
+		btac_update(&next->btac, pc, taddr, true);
+	} else if (!pred_taken) {
+		btac_update(&next->btac, pc, taddr, false);
+	}
+}
+
+void btac_count_miss(const state_t *curr, state_t *next, word_u pc)
+{
+	switch (btac_classify(&curr->btac, pc)) {
+	case BTAC_MISS_NONE:
+		break;
+	case BTAC_MISS_COLD:
+		next->stats.btac_miss_cold++;
+		break;
+	case BTAC_MISS_CAPACITY:
+		next->stats.btac_miss_capacity++;
+		break;
+	case BTAC_MISS_CONFLICT:
+		next->stats.btac_miss_conflict++;
+		break;
 	}
 }
 
@@ -312,7 +482,7 @@ void upd_branch_stats(const rob_t *entry, state_t *next, struct per_pc_stats *pe
 {
 	const word_u pred = entry->data.brt.pred;
 	const word_u act = entry->data.brt.act;
-	struct per_pc_stats tmp;
+	struct per_pc_stats tmp = { 0 };
 	if (!per_pc)
 		per_pc = &tmp;
 	else
@@ -347,9 +517,29 @@ void upd_branch_stats(const rob_t *entry, state_t *next, struct per_pc_stats *pe
 				++next->stats.jalr_btac_incorrect;
 				++per_pc->btac_incorrect;
 			}
+		} else if (entry->dbg_branch_info.pred == ROB_PRED_INDIRECT) {
+			if (pred.u == act.u) {
+				++next->stats.jalr_ind_correct;
+				++per_pc->indirect_correct;
+			} else {
+				++next->stats.jalr_ind_incorrect;
+				++per_pc->indirect_incorrect;
+			}
 		} else {
 			assert(0);
 		}
+		{
+			size_t i;
+			for (i = 0; i < per_pc->targets && i < PER_PC_TARGETS; i++)
+				if (per_pc->target[i].u == act.u)
+					break;
+			/* Stops one past PER_PC_TARGETS: "more than". */
+			if (i == per_pc->targets && i <= PER_PC_TARGETS) {
+				if (i < PER_PC_TARGETS)
+					per_pc->target[i] = act;
+				per_pc->targets++;
+			}
+		}
 		break;
 	case ROB_BRANCH_CMP:
 		if (entry->dbg_branch_info.pred == ROB_PRED_STATIC || entry->dbg_branch_info.pred == ROB_PRED_NONE) {
@@ -386,3 +576,76 @@ void upd_branch_stats(const rob_t *entry, state_t *next, struct per_pc_stats *pe
 }
 
 
+
+void mem_violation_check(state_t *next)
+{
+	stq_mask_t resolved = next->stq.resolved;
+	while (resolved) {
+		const size_t id = __builtin_ctzll(resolved);
+		resolved &= ~STQ_BIT(id);
+
+		const stq_entry_t *store = &next->stq.buffer[id];
+		assert(store->busy && store->addr.u);
+		/* Only younger loads: store->rob_id is the next ROB index. */
+		FOR_ROB_MASK(&next->rob_bypassed, i, store->rob_id & ROB_INDEX_MASK, next->rob_head) {
+			rob_t *rob = &next->rob[i];
+			assert(rob->load.bypassed);
+			if (rob->load.violation)
+				continue;
+			if (!addrs_overlap(rob->load.addr, lsu_op_bytes(rob->load.op),
+					store->addr, lsu_op_bytes(store->op)))
+				continue;
+			tracei("[storeset] load %lu (pc %x) went past store %lu (pc %x) to %x\n",
+				rob->id, rob->pc.u, store->rob_id, store->pc.u, store->addr.u);
+			rob->load.violation = 1;
+			storeset_violation(&next->storeset, rob->pc, store->pc);
+			next->stats.storeset_violation++;
+		}
+	}
+}
+
+static uint8_t load_byte(word_u addr, word_u val, uint32_t at)
+{
+	return val.u >> (8 * (at - addr.u));
+}
+
+/* A load got its value: every younger load to the same bytes that already has
+ * one, with no store in between, must agree with it or be replayed. */
+void load_order_check(state_t *next, size_t rob_id, size_t stq_pos, enum lsu_op op, word_u addr, word_u val)
+{
+	rob_t *load = &next->rob[rob_id - 1];
+	assert(load->id == rob_id);
+	load->load.done = 1;
+	load->load.addr = addr;
+	load->load.op = op;
+	load->load.val = val;
+	load->load.stq_pos = stq_pos;
+	rob_mask_set(&next->rob_loaded, rob_id - 1);
+
+	const size_t bytes = lsu_op_bytes(op);
+	FOR_ROB_MASK(&next->rob_loaded, i, rob_id & ROB_INDEX_MASK, next->rob_head) {
+		rob_t *rob = &next->rob[i];
+		assert(rob->load.done);
+		if (rob->load.violation)
+			continue;
+		/* Stores in between may have changed the bytes, and those are
+		 * not our concern. Neither is anything after them. */
+		if (rob->load.stq_pos != stq_pos)
+			break;
+		const size_t rob_bytes = lsu_op_bytes(rob->load.op);
+		if (!addrs_overlap(rob->load.addr, rob_bytes, addr, bytes))
+			continue;
+		const uint32_t lo = addr.u > rob->load.addr.u ? addr.u : rob->load.addr.u;
+		const uint32_t hi_a = addr.u + bytes, hi_b = rob->load.addr.u + rob_bytes;
+		const uint32_t hi = hi_a < hi_b ? hi_a : hi_b;
+		for (uint32_t at = lo; at != hi; at++) {
+			if (load_byte(addr, val, at) != load_byte(rob->load.addr, rob->load.val, at)) {
+				tracei("[ldb] load %lu (pc %x) saw a different value than older load %lu\n",
+					rob->id, rob->pc.u, rob_id);
+				rob->load.violation = 1;
+				next->stats.load_order_violation++;
+				break;
+			}
+		}
+	}
+}
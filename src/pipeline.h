@@ -14,16 +14,26 @@
 #include "../kernel/include/isa.h"
 
 #include "alu.h"
-#include "bht.h"
+#include "bpred.h"
 #include "bru.h"
 #include "btac.h"
 #include "cdb.h"
 #include "config.h"
 #include "decode.h"
+#include "fetch.h"
+#include "fu.h"
+#include "fuse.h"
+#include "ittage.h"
+#include "loop.h"
 #include "lsu.h"
+#include "mdu.h"
+#include "prf.h"
 #include "ras.h"
+#include "rng.h"
 #include "rob.h"
 #include "rs.h"
+#include "storeset.h"
+#include "stq.h"
 
 #include "config.h"
 #include "util.h"
@@ -43,19 +53,9 @@ enum {
 
 	REG_T3 = 28,
 	REG_T4 = 29,
-};
-
-typedef struct {
-	size_t rob_id;
-	word_u dat;
-} reg_t;
 
-typedef struct {
-	word_u pc;
-	word_u instr;
-	btac_entry_t btac;
-	bht_entry_t bht;
-} fetched_instr_t;
+	PER_PC_TARGETS = 8,
+};
 
 struct per_pc_stats {
 	size_t btac_correct,
@@ -64,7 +64,12 @@ struct per_pc_stats {
 		bht_incorrect,
 		static_correct,
 		static_incorrect,
-		miss;
+		miss,
+		indirect_correct,
+		indirect_incorrect;
+	/* Distinct JALR targets, the first PER_PC_TARGETS kept. */
+	size_t targets;
+	word_u target[PER_PC_TARGETS];
 	enum rob_branch_type type;
 	enum rob_type rob_type;
 
@@ -76,9 +81,14 @@ struct per_pc_stats {
 };
 
 typedef struct {
-	reg_t arf[REG_COUNT];
+	/* Register file and rename tables, shared by curr and next and
+	 * updated in place like the ROB. */
+	struct prf *prf;
 
 	size_t clk;
+	/* Retire hit a break, an abort or an exception: this run stops, or
+	 * goes to the debugger. Per simulation, as seeds run side by side. */
+	bool stop;
 
 	/* On retire mispredicted conditional branch or JALR. */
 	word_u pc_rob_mispredict;
@@ -88,50 +98,75 @@ typedef struct {
 	 * or 	BTAC miss but BHT hit. */
 	word_u pc_decode_predict;
 
-	/* Either from BTAC, or just pc+ISSUE_WIDTH */
+	/* Next block to predict. Either from BTAC, or just pc+ISSUE_WIDTH */
 	word_u pc_fetch;
 
-	/* If we stall and have to repeat ourselves. */
-	word_u pc_last;
-
 	bool fetch_wait_rob_mispredict;
 	bool fetch_wait_jalr_bru;
 
-	bool decode_is_clear;
 	bool decode_drop_next;
 
-	fetched_instr_t fetch_window[ISSUE_WIDTH];
-	fetched_instr_t held_window[ISSUE_WIDTH];
+	struct ftq ftq;
+	struct fetch_buf fetch_buf;
 
 	rs_t rss[RS_COUNT];
+	struct rs_select rs_select;
+	/* Stations with both operands at the start of the cycle and not
+	 * issued yet, and those of them opt_issue puts first. */
+	rs_mask_t rs_ready;
+	rs_mask_t rs_urgent;
 	rs_t ldb[LDB_SIZE];
 
-	alu_t alus[ALU_COUNT];
+	/* Cycle each ALU, multiplier and divider can take its next op, and
+	 * results on the way. */
+	size_t fu_next_issue[FU_COUNT];
+	struct fu_events fu_events;
 	lsu_t lsus[LSU_COUNT];
 	bru_t brus[BRU_COUNT];
 
-	struct bht bht;
 	struct btac btac;
 
-	size_t global_branch_history;
+	/* Conditional branch predictor, one copy per simulation. */
+	struct bpred *bpred;
+	struct bpred_hist bpred_hist;
+	/* Indirect target predictor, likewise. */
+	struct ittage *ittage;
+	struct loop_pred *loop;
 
 	ras_t ras;
 
-	rob_t rob[ROB_SIZE];
+	/* One copy per simulation, updated in place: nothing reads an entry
+	 * as it was at the start of the cycle except retire, which goes by
+	 * rob_ready. Free entries are all zero. */
+	rob_t *rob;
+	/* Entries with their result, as of the start of the cycle in curr. */
+	rob_mask_t rob_ready;
+	/* Loads which went past a store with unknown address, and loads
+	 * which have their value. */
+	rob_mask_t rob_bypassed;
+	rob_mask_t rob_loaded;
+	/* Conditional branches. */
+	rob_mask_t rob_cond;
 	/* Head - index of next insertion,
 	 * Tail - index of next read.
 	 * If head == tail, rob is empty,
 	 * if head == tail+1, rob is full */
 	size_t rob_head;
 	size_t rob_tail;
-	size_t ldb_head;
-	size_t ldb_tail;
+
+	struct stq stq;
+	struct storeset storeset;
 
 	struct cdb cdb;
 
+	/* Memory latency jitter. */
+	struct rng rng;
+
 	struct stats stats;
 } state_t;
 
+#define ROB_COUNT(state) (((state)->rob_head - (state)->rob_tail) & ROB_INDEX_MASK)
+
 #define FOR_INDEX_ROB(state, i) \
 	for (size_t i = state->rob_tail; i != state->rob_head; i = (i + 1) & ROB_INDEX_MASK)
 
@@ -140,11 +175,11 @@ typedef struct {
 
 bool is_link_reg(uint8_t reg);
 
-void pipeline_flush(state_t *next);
-
-bool addrs_may_overlap(word_u this, word_u other);
+void pipeline_flush(const state_t *curr, state_t *next);
 
-bool rob_earlier_store_overlaps(const state_t *curr, const lsu_t *lsu, word_u *val, bool *set_val, bool *dbg_wait_val);
+/* A branch resolved against its prediction: squash everything younger,
+ * put back the rename map, history and RAS, and refetch from act. */
+void branch_recover(const state_t *curr, state_t *next, size_t rob_id, word_u act);
 
 void rob_alloc_only(const state_t *curr, state_t *next, rob_t *rob, enum rob_type type, word_u pc);
 
@@ -152,17 +187,39 @@ void rs_alloc_only(state_t *next, rs_t *rs, enum rs_type type, word_u pc, word_u
 
 void rs_rob_alloc(const state_t *curr, state_t *next, rs_t *rs, rob_t *rob, enum rob_type rob_type, enum rs_type rs_type, word_u pc, word_u op);
 
-void rob_rd(state_t *next, rob_t *rob, uint8_t rd);
+/* Rename rd for this entry, returning its new physical register. */
+preg_t rob_rd(state_t *next, rob_t *rob, uint8_t rd);
+
+/* Result known at decode. */
+void rob_rd_ready(state_t *next, rob_t *rob, word_u val);
+
+/* A move: rd renamed to the register rs is in, and done. */
+void rob_rd_alias(state_t *next, rob_t *rob, uint8_t rd, uint8_t rs);
+
+/* Done, retire may go past it from next cycle. */
+void rob_set_ready(state_t *next, const rob_t *rob);
+
+/* Branch target known. */
+void rob_ready(state_t *next, rob_t *rob, word_u val);
+
+/* Free an entry at retire or on a squash. */
+void rob_free(state_t *next, size_t i);
 
 rob_t *rob_find_free(const state_t *curr, state_t *next);
 
 rs_t *ldb_find_free(const state_t *curr, state_t *next);
 
-void ldb_alloc(const state_t *curr, state_t *next, rs_t *new_ldb);
+size_t rob_age(const state_t *curr, size_t rob_id);
 
 const rs_t *rs_waiting_and_free(const state_t *curr, state_t *next, enum rs_type type);
 
-const rs_t *ldb_next_and_free(const state_t *curr, state_t *next);
+/* Set rs_urgent for opt_issue. */
+void rs_select_urgent(const state_t *curr, state_t *next);
+
+/* Pick up to max loads to send to the LSUs. */
+size_t ldb_next_and_free(const state_t *curr, state_t *next, const rs_t **issue, size_t max);
+
+stq_mask_t load_wait_unknown(size_t stq_dep);
 
 void rs_find_free(const state_t *curr, state_t *next, const rs_t **rs_curr, rs_t **rs_next);
 
@@ -170,7 +227,17 @@ void rs_set_rsrc1(rs_t *rs, uint8_t rsrc1, state_t *next);
 
 void rs_set_rsrc2(rs_t *rs, uint8_t rsrc2, state_t *next);
 
-void bht_btac_update(const state_t *curr, state_t *next, word_u pc, size_t global_history, bool taken, word_u taddr);
+void bht_btac_update(const state_t *curr, state_t *next, const rob_t *entry, bool taken, word_u taddr);
+/* Classify a BTAC miss for a branch decode wanted redirected. */
+void btac_count_miss(const state_t *curr, state_t *next, word_u pc);
+
+/* Check stores whose address arrived this cycle against younger loads
+ * that have already gone past them. */
+void mem_violation_check(state_t *next);
+
+/* Record a load's value and replay younger loads with no store in between
+ * which read the same bytes earlier and got something else. */
+void load_order_check(state_t *next, size_t rob_id, size_t stq_pos, enum lsu_op op, word_u addr, word_u val);
 
 void upd_branch_stats(const rob_t *entry, state_t *next, struct per_pc_stats *per_pc);
 
@@ -0,0 +1,100 @@
+#include "prf.h"
+
+#include <assert.h>
+#include <string.h>
+
+_Static_assert(PRF_SIZE > REG_COUNT, "nothing to rename to");
+_Static_assert(PRF_SIZE <= UINT16_MAX, "preg_t too small");
+
+void prf_init(struct prf *prf)
+{
+	*prf = (struct prf){ 0 };
+	for (size_t i = 0; i < REG_COUNT; i++) {
+		prf->spec[i] = prf->arch[i] = i;
+		prf->ready[i] = 1;
+	}
+	prf_flush(prf);
+}
+
+bool prf_can_rename(const struct prf *prf)
+{
+	return prf->free_head != prf->free_tail;
+}
+
+preg_t prf_rename(struct prf *next, uint8_t rd, preg_t *old)
+{
+	assert(rd && rd < REG_COUNT);
+	assert(prf_can_rename(next));
+	const preg_t p = next->free[next->free_head++ % PRF_SIZE];
+	assert(p);
+	next->ready[p] = 0;
+	next->val[p].u = 0;
+	next->refs[p] = 1;
+	*old = next->spec[rd];
+	next->spec[rd] = p;
+	return p;
+}
+
+preg_t prf_alias(struct prf *next, uint8_t rd, uint8_t rs, preg_t *old)
+{
+	assert(rd && rd < REG_COUNT && rs && rs < REG_COUNT);
+	const preg_t p = next->spec[rs];
+	assert(p && next->refs[p]);
+	next->refs[p]++;
+	*old = next->spec[rd];
+	next->spec[rd] = p;
+	return p;
+}
+
+void prf_unalias(struct prf *next, preg_t p)
+{
+	/* Whatever it aliased still holds it. */
+	assert(p && next->refs[p] > 1);
+	next->refs[p]--;
+}
+
+void prf_write(struct prf *next, preg_t p, word_u val)
+{
+	assert(p);
+	next->val[p] = val;
+	next->ready[p] = 1;
+}
+
+void prf_retire(struct prf *next, uint8_t rd, preg_t p, preg_t old)
+{
+	assert(rd && rd < REG_COUNT && p && old);
+	assert(next->arch[rd] == old);
+	next->arch[rd] = p;
+	assert(next->refs[old]);
+	if (--next->refs[old])
+		return;
+	next->free[next->free_tail++ % PRF_SIZE] = old;
+	assert(next->free_tail - next->free_head < PRF_SIZE);
+}
+
+struct prf_ckpt prf_checkpoint(const struct prf *prf)
+{
+	struct prf_ckpt ckpt = { .free_head = prf->free_head };
+	memcpy(ckpt.spec, prf->spec, sizeof(ckpt.spec));
+	return ckpt;
+}
+
+void prf_restore(struct prf *next, const struct prf_ckpt *ckpt)
+{
+	assert(ckpt->free_head <= next->free_head);
+	memcpy(next->spec, ckpt->spec, sizeof(next->spec));
+	next->free_head = ckpt->free_head;
+}
+
+void prf_flush(struct prf *next)
+{
+	memset(next->refs, 0, sizeof(next->refs));
+	for (size_t i = 0; i < REG_COUNT; i++)
+		next->refs[next->arch[i]]++;
+	memcpy(next->spec, next->arch, sizeof(next->spec));
+
+	next->free_head = next->free_tail = 0;
+	for (size_t p = 0; p < PRF_SIZE; p++)
+		if (!next->refs[p])
+			next->free[next->free_tail++] = p;
+}
@@ -0,0 +1,74 @@
+/* Physical Register File.
+ * Every register value, architectural or in flight, lives here. Decode
+ * renames each destination to a register off the free list, and retire
+ * makes that mapping architectural and frees the register it replaced.
+ * The free list is a FIFO which wrong path allocations only ever take
+ * from the front of, so a checkpoint is just the rename table and the
+ * position of the front.
+ * A move renames its destination to its source's register, so registers
+ * are counted by the mappings to them, and freed when the last goes. */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "word.h"
+
+/* Register 0 always holds x0, so a tag of 0 means no wait. */
+typedef uint16_t preg_t;
+
+struct prf {
+	word_u val[PRF_SIZE];
+	bool ready[PRF_SIZE];
+	/* Rename table entries, architectural or in flight, mapped here. */
+	uint16_t refs[PRF_SIZE];
+
+	/* Speculative rename table, changed by decode. */
+	preg_t spec[REG_COUNT];
+	/* Retirement rename table. */
+	preg_t arch[REG_COUNT];
+
+	/* Free registers between head and tail, which only count up. */
+	preg_t free[PRF_SIZE];
+	size_t free_head;
+	size_t free_tail;
+};
+
+struct prf_ckpt {
+	preg_t spec[REG_COUNT];
+	size_t free_head;
+};
+
+/* Each architectural register in a physical one of the same number. */
+void prf_init(struct prf *prf);
+
+/* Whether a destination can be renamed. */
+bool prf_can_rename(const struct prf *prf);
+
+/* Give rd a new register, returning it and the one it had in old. */
+preg_t prf_rename(struct prf *next, uint8_t rd, preg_t *old);
+
+/* Map rd to the register rs is in, returning it and rd's old one. */
+preg_t prf_alias(struct prf *next, uint8_t rd, uint8_t rs, preg_t *old);
+
+/* A squashed alias of p. Any other squashed renames go with the
+ * checkpoint. */
+void prf_unalias(struct prf *next, preg_t p);
+
+/* Result arrived. */
+void prf_write(struct prf *next, preg_t p, word_u val);
+
+/* rd is now architecturally in p, and old has one mapping fewer. */
+void prf_retire(struct prf *next, uint8_t rd, preg_t p, preg_t old);
+
+struct prf_ckpt prf_checkpoint(const struct prf *prf);
+/* Registers given out since the checkpoint go back on the free list. */
+void prf_restore(struct prf *next, const struct prf_ckpt *ckpt);
+
+/* Nothing in flight: back to the retirement table, all else free. */
+void prf_flush(struct prf *next);
+
+/* Architectural value of r. */
+static inline word_u prf_arch_val(const struct prf *prf, uint8_t r)
+{
+	return prf->val[prf->arch[r]];
+}
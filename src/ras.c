@@ -2,31 +2,45 @@
 
 #include <assert.h>
 
-void ras_do(const ras_t *curr, ras_t *next)
+word_u ras_top(const ras_t *ras)
 {
-	for (size_t i = 0; i < RAS_SIZE; i++) {
-		next->buffer[i] = curr->buffer[i];
-	}
+	if (!ras->count)
+		return (word_u){ 0 };
+	return ras->buffer[ras->tos];
+}
+
+bool ras_push(ras_t *ras, word_u addr)
+{
+	assert(addr.u);
+	ras->tos = (ras->tos + 1) & RAS_INDEX_MASK;
+	ras->buffer[ras->tos] = addr;
+	if (ras->count == RAS_SIZE)
+		return true;
+	ras->count++;
+	return false;
+}
+
+bool ras_pop(ras_t *ras)
+{
+	if (!ras->count)
+		return false;
+	ras->tos = (ras->tos - 1) & RAS_INDEX_MASK;
+	ras->count--;
+	return true;
+}
 
-	switch (curr->cmd) {
-	case RAS_NONE:
-		next->head_ptr = curr->head_ptr;
-		next->head = curr->head;
-		assert(!curr->arg.u);
-		break;
-	case RAS_POP:
-		assert(!curr->arg.u);
-		next->buffer[curr->head_ptr] = (word_u){ 0 };
-		next->head_ptr = (curr->head_ptr - 1) & RAS_INDEX_MASK;
-		break;
-	case RAS_PUSH:
-		assert(curr->arg.u);
-		next->head_ptr = (curr->head_ptr + 1) & RAS_INDEX_MASK;
-		next->buffer[next->head_ptr] = curr->arg;
-		break;
-	default:
-		assert(0);
-	}
-	next->head = next->buffer[next->head_ptr];
+struct ras_ckpt ras_checkpoint(const ras_t *ras)
+{
+	return (struct ras_ckpt) {
+		.tos = ras->tos,
+		.count = ras->count,
+		.top = ras->buffer[ras->tos],
+	};
 }
 
+void ras_restore(ras_t *ras, const struct ras_ckpt *ckpt)
+{
+	ras->tos = ckpt->tos;
+	ras->count = ckpt->count;
+	ras->buffer[ras->tos] = ckpt->top;
+}
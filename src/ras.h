@@ -1,20 +1,34 @@
+/* Return Address Stack.
+ * Circular, so a push when full overwrites the oldest entry. Every branch
+ * and load checkpoints the top pointer and value in its ROB entry, and
+ * recovery puts them back rather than emptying the stack. */
 #pragma once
+#include <stdbool.h>
 #include "config.h"
 #include "word.h"
 
 typedef struct {
-	size_t head_ptr;
-	word_u head;
+	size_t tos;
+	/* Entries pushed and not popped, up to RAS_SIZE. */
+	size_t count;
 	word_u buffer[RAS_SIZE];
-
-	enum {
-		RAS_NONE,
-		RAS_POP,
-		RAS_PUSH,
-	} cmd;
-	word_u arg;
 } ras_t;
 
-/* Update our state, with respect to the specified operation. */
-void ras_do(const ras_t *curr, ras_t *next);
+struct ras_ckpt {
+	size_t tos;
+	size_t count;
+	word_u top;
+};
+
+/* 0 if empty. */
+word_u ras_top(const ras_t *ras);
+
+/* Return whether the oldest entry was overwritten. */
+bool ras_push(ras_t *ras, word_u addr);
+/* Return false if there was nothing to pop. */
+bool ras_pop(ras_t *ras);
 
+struct ras_ckpt ras_checkpoint(const ras_t *ras);
+/* Entries below the top may since have been overwritten on the wrong
+ * path; those stay lost. */
+void ras_restore(ras_t *ras, const struct ras_ckpt *ckpt);
@@ -0,0 +1,42 @@
+#include "rng.h"
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+/* splitmix64, as recommended for seeding the xoshiro family. */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void rng_seed(struct rng *rng, uint64_t seed)
+{
+	uint64_t a = splitmix64(&seed);
+	uint64_t b = splitmix64(&seed);
+	rng->s[0] = a;
+	rng->s[1] = a >> 32;
+	rng->s[2] = b;
+	rng->s[3] = b >> 32;
+}
+
+uint32_t rng_next(struct rng *rng)
+{
+	uint32_t *s = rng->s;
+	const uint32_t result = rotl(s[1] * 5, 7) * 9;
+	const uint32_t t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = rotl(s[3], 11);
+
+	return result;
+}
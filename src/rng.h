@@ -0,0 +1,15 @@
+/* Pseudo-random number generator (xoshiro128**).
+ * Owned by the simulation, so runs are reproducible from the seed. */
+#pragma once
+
+#include <stdint.h>
+
+struct rng {
+	uint32_t s[4];
+};
+
+/* Expand a 64 bit seed into the generator state. */
+void rng_seed(struct rng *rng, uint64_t seed);
+
+/* Next 32 bits of output. */
+uint32_t rng_next(struct rng *rng);
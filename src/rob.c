@@ -16,46 +16,28 @@ const char *rob_type_str(enum rob_type t)
 	}
 }
 
-void rob_allocate(rob_t *rob, size_t id, enum rob_type type, word_u pc, size_t global_branch_history)
+/* First set in [from, to), which mustn't wrap, or to. */
+static size_t rob_mask_first(const rob_mask_t *m, size_t from, size_t to)
 {
-	assert(rob);
-
-	rob->id = id;
-	rob->type = type;
-	rob->pc = pc;
-	if (type == ROB_INSTR_BRANCH)
-		rob->branch_ctrl.global_history = global_branch_history;
-}
-
-void rob_ready(rob_t *rob, word_u val)
-{
-	assert(rob->id);
-	assert(!rob->ready);
-	rob->ready = 1;
-	switch (rob->type) {
-	case ROB_INSTR_REGISTER:
-		assert(!rob->data.reg.val.u);
-		rob->data.reg.val = val;
-		break;
-	case ROB_INSTR_BRANCH:
-		assert(!rob->data.brt.act.u);
-		rob->data.brt.act = val;
-		break;
-	default:
-		assert(0);
+	size_t w = from / 64;
+	uint64_t bits = m->w[w] & (~(uint64_t)0 << (from % 64));
+	while (!bits) {
+		if (++w * 64 >= to)
+			return to;
+		bits = m->w[w];
 	}
+	const size_t i = w * 64 + __builtin_ctzll(bits);
+	return i < to ? i : to;
 }
 
-word_u rob_get_reg_val(const rob_t *rob)
+size_t rob_mask_next(const rob_mask_t *m, size_t from, size_t to)
 {
-	switch (rob->type) {
-	case ROB_INSTR_REGISTER:
-		return rob->data.reg.val;
-	case ROB_INSTR_DEBUG:
-		assert(rob->data.debug.opcode.u == DBG_OP_INPUT);
-		return rob->data.debug.operand;
-	default:
-		assert(0);
-	}
+	if (from == to)
+		return to;
+	if (from < to)
+		return rob_mask_first(m, from, to);
+	const size_t i = rob_mask_first(m, from, ROB_SIZE);
+	if (i != ROB_SIZE)
+		return i;
+	return to ? rob_mask_first(m, 0, to) : to;
 }
-
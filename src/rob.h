@@ -1,10 +1,15 @@
 /* An entry in the ROB. */
 #pragma once
 
+#include "config.h"
 #include "util.h"
 #include "word.h"
 #include "lsu.h"
+#include "prf.h"
+#include "bpred.h"
+#include "ras.h"
 #include <stddef.h>
+#include <stdint.h>
 
 #include "../kernel/include/isa.h"
 
@@ -30,7 +35,23 @@ typedef struct {
 		bool_t consider_prediction; // i.e. should we flush when pred != act?
 		bool_t change_bht;
 		bool_t pred_taken; // only set where change_bht is.
-		size_t global_history;
+		/* Predictor history before this instruction. */
+		struct bpred_hist hist;
+		/* RAS after this instruction's push or pop. */
+		struct ras_ckpt ras;
+		/* Rename state after this instruction (and its link write). */
+		struct prf_ckpt rename;
+		/* Mispredict already dealt with when it resolved. */
+		bool recovered;
+		/* JALR which isn't a return: trains the indirect predictor. */
+		bool indirect;
+		/* Conditional branches: what the loop predictor had to say. */
+		enum {
+			ROB_LOOP_NONE,
+			ROB_LOOP_AGREE,
+			ROB_LOOP_OVERRIDE,
+		} loop;
+		bool backward;
 	} branch_ctrl;
 
 	// For stats.
@@ -48,13 +69,28 @@ typedef struct {
 			ROB_PRED_BTAC,
 			ROB_PRED_BHT,
 			ROB_PRED_RAS,
+			ROB_PRED_INDIRECT,
 		} pred;
 	} dbg_branch_info;
 	bool dbg_was_load;
+	/* Stands for two instructions, see fuse.h. */
+	bool fused;
+	/* Loads which took their value past a store with an unknown address
+	 * are checked when that store's address arrives, and loads done out of
+	 * order are checked against older loads to the same bytes. */
+	struct {
+		bool bypassed;
+		bool done;
+		bool violation;
+		word_u addr;
+		enum lsu_op op;
+		word_u val;
+		size_t stq_pos;
+	} load;
 
 	// Mostly 
 	union {
-		// rob_instr_reg or rob_instr_store
+		// rob_instr_reg (val unused, it's in the PRF) or rob_instr_store
 		struct {
 			word_u dest;
 			word_u val;
@@ -71,16 +107,46 @@ typedef struct {
 		} debug;
 	} data;
 
-	bool ready;
+	/* Registers: physical register written, and the one it replaces,
+	 * freed when this retires. */
+	preg_t preg;
+	preg_t old_preg;
+	/* A move, preg shared with its source. */
+	bool aliased;
+
 	bool exception;
 } rob_t;
 
-/* Allocate a ROB entry */
-void rob_allocate(rob_t *rob, size_t id, enum rob_type type, word_u pc, size_t global_branch_history);
+enum {
+	ROB_MASK_WORDS = (ROB_SIZE + 63) / 64,
+};
+
+/* One bit per ROB index, so per-cycle work goes by the entries of
+ * interest rather than the size of the ROB. */
+typedef struct {
+	uint64_t w[ROB_MASK_WORDS];
+} rob_mask_t;
+
+static inline void rob_mask_set(rob_mask_t *m, size_t i)
+{
+	m->w[i / 64] |= (uint64_t)1 << (i % 64);
+}
+
+static inline void rob_mask_clear(rob_mask_t *m, size_t i)
+{
+	m->w[i / 64] &= ~((uint64_t)1 << (i % 64));
+}
+
+static inline bool rob_mask_test(const rob_mask_t *m, size_t i)
+{
+	return m->w[i / 64] >> (i % 64) & 1;
+}
 
-/* Mark a ROB entry valid, with the provided data. */
-void rob_ready(rob_t *rob, word_u val);
+/* First index set from "from" up to (not including) "to", going round
+ * the end of the ROB, or "to" if there isn't one. */
+size_t rob_mask_next(const rob_mask_t *m, size_t from, size_t to);
 
-/* Get the RD value from a ROB entry. */
-word_u rob_get_reg_val(const rob_t *rob);
+#define FOR_ROB_MASK(m, i, from, to) \
+	for (size_t i = rob_mask_next((m), (from), (to)); i != (to); \
+		i = rob_mask_next((m), (i + 1) & ROB_INDEX_MASK, (to)))
 
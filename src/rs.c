@@ -15,6 +15,10 @@ const char *rs_type_str(enum rs_type t)
 		return "branch";
 	case RS_DBG:
 		return "debug";
+	case RS_MUL:
+		return "mul";
+	case RS_DIV:
+		return "div";
 	default:
 		return "invalid";
 	}
@@ -34,3 +38,26 @@ void rs_allocate(rs_t *rs, enum rs_type type, word_u pc, word_u op, size_t clk)
 }
 
 
+
+void rs_select_insert(struct rs_select *sel, size_t i, enum rs_type type)
+{
+	assert(i < RS_COUNT);
+	assert(type && type <= RS_TYPE_COUNT);
+	const rs_mask_t bit = RS_BIT(i);
+	for (size_t t = 0; t <= RS_TYPE_COUNT; t++)
+		sel->type[t] &= ~bit;
+	sel->type[type] |= bit;
+	for (size_t j = 0; j < RS_COUNT; j++)
+		sel->older[j] &= ~bit;
+	sel->older[i] = ~bit;
+}
+
+size_t rs_select_oldest(const struct rs_select *sel, rs_mask_t cand)
+{
+	for (rs_mask_t c = cand; c; c &= c - 1) {
+		const size_t i = __builtin_ctzll(c);
+		if (!(sel->older[i] & cand))
+			return i;
+	}
+	return RS_COUNT;
+}
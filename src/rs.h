@@ -4,6 +4,9 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "prf.h"
 #include "word.h"
 
 enum rs_type {
@@ -12,8 +15,10 @@ enum rs_type {
 	RS_ALU,
 	RS_BR,
 	RS_DBG,
+	RS_MUL,
+	RS_DIV,
 
-	RS_TYPE_COUNT = RS_DBG,
+	RS_TYPE_COUNT = RS_DIV,
 };
 
 const char *rs_type_str(enum rs_type t);
@@ -25,6 +30,7 @@ typedef struct {
 
 	/* Architectural Fields */
 	word_u op;
+	/* Physical registers still to come, 0 once vj, vk hold the value. */
 	size_t qj, qk;
 	word_u vj, vk;
 	word_u pc;
@@ -32,10 +38,37 @@ typedef struct {
 	word_u addr;
 	bool busy;
 	word_u predicted_taddr;
+	/* Stores: own store queue entry.
+	 * Loads: store queue head when decoded. */
+	size_t stq_id;
+	/* Loads: store predicted to alias, or STQ_SIZE. */
+	size_t stq_dep;
 
 	size_t rob_id;
+	/* Result goes to this physical register, 0 if none. */
+	preg_t dest;
 } rs_t;
 
 /* Allocate a reservation station. */
 void rs_allocate(rs_t *rs, enum rs_type type, word_u pc, word_u op, size_t clk);
 
+/* One bit per reservation station. */
+typedef uint64_t rs_mask_t;
+_Static_assert(RS_COUNT <= 64, "rs_mask_t has a bit per station");
+
+#define RS_BIT(i) ((rs_mask_t)1 << (i))
+
+/* Issue select. The age matrix has bit j of older[i] set if station j
+ * was allocated before station i, so the oldest of a set of stations is
+ * the one with none of the others in its row. */
+struct rs_select {
+	rs_mask_t type[RS_TYPE_COUNT + 1];
+	rs_mask_t older[RS_COUNT];
+};
+
+/* Station i was just allocated, it is the youngest. */
+void rs_select_insert(struct rs_select *sel, size_t i, enum rs_type type);
+
+/* Oldest station in cand, or RS_COUNT if it's empty. */
+size_t rs_select_oldest(const struct rs_select *sel, rs_mask_t cand);
+
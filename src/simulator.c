@@ -4,8 +4,37 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "debugger.h"
+#include "bhtsweep.h"
+
+/* Options shared by every run. */
+struct sim_opts {
+	bool bench_only;
+	bool granular_stats;
+	bool permissive;
+	/* Multi-seed runs: never enter the debugger, and don't print per-run stats. */
+	bool quiet;
+	FILE *trace_pc;
+	/* Retired conditional branches, for predict-only runs. */
+	FILE *trace_branches;
+	/* Conditional branch predictor. */
+	const char *bpred;
+	/* Train a range of BHT configurations on retired branches. */
+	bool bht_sweep;
+};
+
+/* A single run of the binary, and its outcome. */
+struct sim_run {
+	uint64_t seed;
+
+	bool ok;
+	size_t cycles;
+	struct stats stats;
+};
 
 void handle_sigint(int _)
 {
@@ -14,7 +43,7 @@ void handle_sigint(int _)
 	debugger_pause = 1;
 }
 
-size_t binary_load(char *flName, uint8_t *mem, word_u *entrypoint)
+size_t binary_load(char *flName, uint8_t **bin, word_u *entrypoint)
 {
 	FILE *f  = fopen(flName, "rb");
 	if (!f) {
@@ -28,7 +57,9 @@ size_t binary_load(char *flName, uint8_t *mem, word_u *entrypoint)
 
 	assert(x < MEM_SIZE && "Binary is too big.");
 
-	fread(mem + BIN_OFFSET, sizeof(uint8_t), x, f);
+	*bin = malloc(x);
+	assert(*bin);
+	fread(*bin, sizeof(uint8_t), x, f);
 	fclose(f);
 
 	printf("Have binary of size %lu.\n", x);
@@ -51,77 +82,19 @@ size_t binary_load(char *flName, uint8_t *mem, word_u *entrypoint)
 	return x;
 }
 
-int main(int argc, char **argv)
+void simulate(const uint8_t *bin, size_t bin_size, word_u entry, struct sim_opts *opts, struct sim_run *result)
 {
-	if (argc < 2) {
-		fprintf(stderr, "Specify binary\n");
-		return -1;
-	}
-
-	/* Debugger sigint handler. */
-	{
-		struct sigaction sigint;
-		sigint.sa_handler = handle_sigint;
-		sigemptyset(&sigint.sa_mask);
-		sigint.sa_flags = 0;
-
-		sigaction(SIGINT, &sigint, NULL);
-	}
-
-	static_assert(sizeof(uint8_t) == 1, "Need 8 bit chars.");
-
 	uint8_t *mem = calloc(1, MEM_SIZE);
 	assert(mem);
-
-	word_u entry;
-	const size_t bin_size = binary_load(argv[1], mem, &entry);
+	memcpy(mem + BIN_OFFSET, bin, bin_size);
 	const size_t bin_region = BIN_OFFSET + bin_size;
-	if (!bin_size) {
-		free(mem);
-		return -1;
-	}
 
-	bool bench_only = 0;
-	bool granular_stats = 0;
-	bool permissive = 0;
-	FILE *trace_pc = NULL;
-	for (int i = 2; i < argc; i++) {
-		if (strcmp(argv[i], "bench") == 0) {
-			bench_only = 1;
-			tracei_enabled = 0;
-			debugger_pause = 0;
-		} else if (strcmp(argv[i], "loud") == 0) {
-			tracei_enabled = 1;
-		} else if (strcmp(argv[i], "granular") == 0) {
-			granular_stats = 1;
-		} else if (strcmp(argv[i], "trace") == 0) {
-			if (!trace_pc)
-				trace_pc = fopen("pc_trace", "wb");
-			if (!trace_pc)
-				fprintf(stderr, "Failed to open trace file");
-		} else if (strcmp(argv[i], "static") == 0) {
-			feature_branch_bht_btac = false;
-		} else if (strcmp(argv[i], "no2level") == 0) {
-			feature_2level = false;
-		} else if (strcmp(argv[i], "noforward") == 0) {
-			feature_store_forward = false;
-		} else if (strcmp(argv[i], "clearhistoryoncall") == 0) {
-			opt_clearhistoncall = true;
-		} else if (strcmp(argv[i], "1bitbht") == 0) {
-			opt_1bitbht = true;
-		} else if (strcmp(argv[i], "nospec") == 0) {
-			opt_nospec = true;
-		} else if (strcmp(argv[i], "gshare") == 0) {
-			opt_gshare = true;
-		} else if (strcmp(argv[i], "nostorechk") == 0) {
-			opt_nostorechk = true;
-		} else if (strcmp(argv[i], "permissive") == 0) {
-			permissive = true;
-		} else {
-			fprintf(stderr, "Unknown option: %s\n", argv[i]);
-			return -1;
-		}
-	}
+	const bool bench_only = opts->bench_only;
+	const bool permissive = opts->permissive;
+	FILE *trace_pc = opts->trace_pc;
+	FILE *trace_branches = opts->trace_branches;
+	size_t trace_branches_retired = 0;
+	struct bht_sweep *sweep = opts->bht_sweep ? bht_sweep_create() : NULL;
 
 //	LIST_HEAD(breakpoints);
 
@@ -131,23 +104,44 @@ int main(int argc, char **argv)
 	next->fetch_wait_rob_mispredict = 1;
 	next->pc_rob_mispredict = entry;
 
+	rng_seed(&next->rng, result->seed);
+	next->bpred = bpred_create(opts->bpred ? opts->bpred : "bht");
+	assert(next->bpred);
+	bpred_hist_init(&next->bpred_hist);
+	btac_init(&next->btac, bin_region / 4);
+	next->ittage = ittage_create();
+	next->loop = loop_create();
+	next->rob = calloc(ROB_SIZE, sizeof(rob_t));
+	assert(next->rob);
+	next->prf = malloc(sizeof(*next->prf));
+	assert(next->prf);
+	next->stats.seed = result->seed;
+
 //	assert(bin_size % 4 == 0);
 	struct per_pc_stats *per_pc_stats = NULL;
-	if (granular_stats) {
+	if (opts->granular_stats) {
 		per_pc_stats = calloc(bin_size, sizeof(struct per_pc_stats));
 		if (!per_pc_stats) {
 			fprintf(stderr, "Failed to alloc per-instr stats.\n");
 		}
 	}
 
-	next->arf[REG_SP].dat.u = STACK_LOCATION;
-	next->arf[REG_TP].dat.u = THREAD_LOCATION;
+	prf_init(next->prf);
+	next->prf->val[next->prf->arch[REG_SP]].u = STACK_LOCATION;
+	next->prf->val[next->prf->arch[REG_TP]].u = THREAD_LOCATION;
 
-	if (debugger_pause)
+	if (debugger_pause && !opts->quiet)
 		printf("Press 'c' to begin execution.\n");
 
 	bool run = 1;
-	while (run && !debugger(next, mem /*, breakpoints*/)) {
+	while (run) {
+		/* Retire wanted to stop: that ends a quiet run, otherwise it's
+		 * over to the debugger. */
+		if (next->stop && !opts->quiet)
+			debugger_pause = 1;
+		if (opts->quiet ? next->stop || debugger_pause : debugger(next, mem /*, breakpoints*/))
+			break;
+
 		if (curr) {
 			free((void*)curr);
 		}
@@ -156,15 +150,38 @@ int main(int argc, char **argv)
 		next = calloc(1, sizeof(state_t));
 		next->clk = curr->clk + 1;
 		next->rob_head = curr->rob_head;
-		next->ldb_head = curr->ldb_head;
 		next->stats = curr->stats;
+		next->rng = curr->rng;
+		next->bpred = curr->bpred;
+		next->bpred_hist = curr->bpred_hist;
+		next->ittage = curr->ittage;
+		next->loop = curr->loop;
+		next->ras = curr->ras;
 
 		tracei("\n");
 
-		/* Copy arf as-is (we should modify it only in retire) */
-		memcpy(next->arf, curr->arf, sizeof(curr->arf));
-		/* Same for ROB (ish) */
-		memcpy(next->rob, curr->rob, sizeof(curr->rob));
+		/* Results on the CDB land in the register file, in place. */
+		next->prf = curr->prf;
+		for (size_t i = 0; i < CDB_WIDTH; i++) {
+			const cdb_entry *cdb = &curr->cdb.buffer[i];
+			if (cdb->rob_id && cdb->preg)
+				prf_write(next->prf, cdb->preg, cdb->data);
+		}
+		/* ROB is updated in place. */
+		next->rob = curr->rob;
+		next->rob_ready = curr->rob_ready;
+		next->rob_bypassed = curr->rob_bypassed;
+		next->rob_loaded = curr->rob_loaded;
+		next->rob_cond = curr->rob_cond;
+		/* Store queue is then updated by the RS, decode and retire. */
+		next->stq = curr->stq;
+		next->stq.resolved = 0;
+		next->storeset = curr->storeset;
+		if (next->clk % STORESET_CLEAR_CYCLES == 0)
+			storeset_clear(&next->storeset);
+		next->rs_select = curr->rs_select;
+		memcpy(next->fu_next_issue, curr->fu_next_issue, sizeof(curr->fu_next_issue));
+		next->fu_events = curr->fu_events;
 		/* Copy reservation stations, modifying if we're waiting for an operand on the CDB */
 		for (size_t i = 0; i < RS_COUNT + LDB_SIZE; i++) {
 			const rs_t *old; 
@@ -178,6 +195,8 @@ int main(int argc, char **argv)
 
 			if (old->busy) {
 				assert(old->type);
+				if (i < RS_COUNT && !old->qj && !old->qk)
+					next->rs_ready |= RS_BIT(i);
 				rs_t *new;
 				if (i < RS_COUNT)
 					new = &next->rss[i];
@@ -185,7 +204,7 @@ int main(int argc, char **argv)
 					new = &next->ldb[i - RS_COUNT];
 				*new = *old;
 				const cdb_entry *cdb = NULL;
-				if (old->qj && (cdb = cdb_with_rob(&curr->cdb, old->qj))) {
+				if (old->qj && (cdb = cdb_with_preg(&curr->cdb, old->qj))) {
 					tracei("[rs] writeback op1 to %lu from %lu\n", old->rob_id, old->qj);
 					assert(old->busy);
 					new->qj = 0;
@@ -197,13 +216,17 @@ int main(int argc, char **argv)
 						tracei("[rs] %lu, pc %x now has mem addr %x\n", old->rob_id, old->pc.u, new->addr.u);
 						if (!new->addr.u)
 							new->addr.u = 0xFFffFFff;
+						if (old->type == RS_STORE)
+							stq_set_addr(&next->stq, old->stq_id, new->addr);
 					}
 				}
-				if (old->qk && (cdb = cdb_with_rob(&curr->cdb, old->qk))) {
+				if (old->qk && (cdb = cdb_with_preg(&curr->cdb, old->qk))) {
 					tracei("[rs] writeback op2 to %lu from %lu\n", old->rob_id, old->qk);
 					assert(old->busy);
 					new->qk = 0;
 					new->vk = cdb->data;
+					if (old->type == RS_STORE)
+						stq_set_val(&next->stq, old->stq_id, new->vk);
 				}
 				assert(!cdb_with_rob(&curr->cdb, old->rob_id));
 				if (0 == new->qj && 0 == new->qk) {
@@ -219,163 +242,209 @@ int main(int argc, char **argv)
 				}
 			}
 		}
-		/* Copy ROB, marking ready where appropriate. */
-		FOR_INDEX_ROB(curr, i) {
-			const rob_t *old = &curr->rob[i];
-			rob_t *new = &next->rob[i];
-			if (!(old->id && old->type)) {
-				fprintf(stderr, "Head: %lu, tail %lu\n", curr->rob_tail, curr->rob_head);
-				fprintf(stderr, "Rob entry %lu had id %lu, type %s\n",
-					i, old->id, rob_type_str(old->type));
+		if (opt_issue != ISSUE_OLDEST)
+			rs_select_urgent(curr, next);
+		/* Mark ROB entries with results on the CDB ready. */
+		for (size_t i = 0; i < CDB_WIDTH; i++) {
+			const cdb_entry *cdb = &curr->cdb.buffer[i];
+			if (!cdb->rob_id)
+				continue;
+			rob_t *new = &next->rob[cdb->rob_id - 1];
+			/* Debug ops put their result out as they retire. */
+			if (new->id != cdb->rob_id)
+				continue;
+			assert(new->type);
+			if (rob_mask_test(&curr->rob_ready, cdb->rob_id - 1)) {
+				printf("rob entry %lu ready but had result on cdb\n", new->id);
 				assert(0);
 			}
-			assert(old->id);
-			assert(old->type);
-			assert(old->type != ROB_INSTR_REGISTER ||
-				(old->data.reg.dest.u && curr->arf[old->data.reg.dest.u].rob_id));
-			*new = *old;
-
-			const cdb_entry *cdb = cdb_with_rob(&curr->cdb, old->id);
-			if (cdb) {
-				if (old->ready) {
-					printf("rob entry %lu ready: %d but had result on cdb\n",
-						old->id, old->ready);
-					assert(0);
-				}
-				// Obviously no switching in hw.
-				switch (old->type) {
-				case ROB_INSTR_REGISTER:
-					tracei("[rob] %lu to reg %s have val %u (0x%x)\n",
-						old->id,
-						reg_name(old->data.reg.dest.u),
-						cdb->data.u, cdb->data.u
-					);
-					new->data.reg.val = cdb->data;
-					break;
-				case ROB_INSTR_STORE:
-					tracei("[rob] %lu store to %x has val %u 0x%x\n",
-						old->id,
-						old->data.reg.dest.u,
-						cdb->data.u, cdb->data.u
-					);
-					new->data.reg.val = cdb->data;
-					break;
-				case ROB_INSTR_BRANCH:
-					tracei("[rob] %lu have branch target %lu (predicted %lu)\n",
-						old->id,
-						cdb->data.u,
-						old->data.brt.pred
-					);
-					new->data.brt.act = cdb->data;
-					break;
-				case ROB_INSTR_DEBUG:
-				default:
-					assert(0);
-				}
-				new->ready = 1;
+			// Obviously no switching in hw.
+			switch (new->type) {
+			case ROB_INSTR_REGISTER:
+				tracei("[rob] %lu to reg %s have val %u (0x%x)\n",
+					new->id,
+					reg_name(new->data.reg.dest.u),
+					cdb->data.u, cdb->data.u
+				);
+				assert(new->data.reg.dest.u && cdb->preg == new->preg);
+				break;
+			case ROB_INSTR_STORE:
+				tracei("[rob] %lu store to %x has val %u 0x%x\n",
+					new->id,
+					new->data.reg.dest.u,
+					cdb->data.u, cdb->data.u
+				);
+				new->data.reg.val = cdb->data;
+				break;
+			case ROB_INSTR_BRANCH:
+				tracei("[rob] %lu have branch target %lu (predicted %lu)\n",
+					new->id,
+					cdb->data.u,
+					new->data.brt.pred
+				);
+				new->data.brt.act = cdb->data;
+				break;
+			case ROB_INSTR_DEBUG:
+			default:
+				assert(0);
 			}
+			rob_set_ready(next, new);
 		}
 
-		next->global_branch_history = curr->global_branch_history;
 
-/* Fetch. i.e. take PC from deepest in pipeline, otherwise as PC+4 if allowed. */
-		word_u window_pc = { 0 };
-		/* for 1-3, decode will be reset anyway. */
-		/* 1) Mispredict on rob retire. CMP */
+/* Fetch. i.e. take PC from deepest in pipeline, otherwise carry on from
+ * the BTAC's prediction. */
+		next->ftq = curr->ftq;
+		next->fetch_buf = curr->fetch_buf;
+		next->pc_fetch = curr->pc_fetch;
+		word_u redirect = { 0 };
+		bool fetch_hold = false;
+		/* 1) Mispredict, from the ROB or the BRU. */
 		if (curr->fetch_wait_rob_mispredict) {
 			if (curr->pc_rob_mispredict.u) {
-				window_pc = curr->pc_rob_mispredict;
-				tracei("[if] Mispredict from ROB: pc now %x\n", window_pc);
+				redirect = curr->pc_rob_mispredict;
+				tracei("[if] Mispredict from ROB: pc now %x\n", redirect.u);
 			} else {
 				tracei("[if] Hold on ROB mispredict addr\n");
 				next->fetch_wait_rob_mispredict = 1;
 				next->stats.stall_mispredict++;
+				fetch_hold = true;
 			}
 		}
 		/* 2) Exec. i.e. JALR where where BTAC missed.
 		 * Safe as must have been last issued instr. */
 		else if (curr->fetch_wait_jalr_bru) {
 			if (curr->pc_exec_bru.u) {
-				window_pc = curr->pc_exec_bru;
-				tracei("[if] Have JALR addr from BRU: pc now %x\n", window_pc.u);
+				redirect = curr->pc_exec_bru;
+				tracei("[if] Have JALR addr from BRU: pc now %x\n", redirect.u);
 			} else {
 				tracei("[if] Hold on JALR from BRU\n");
 				next->fetch_wait_jalr_bru = 1;
+				fetch_hold = true;
 			}
 		}
 		/* 3) Decode (bht/static) branch prediction, or pc+imm jump. JAL, CMP */
 		else if (curr->pc_decode_predict.u) {
-			window_pc = curr->pc_decode_predict;
-			tracei("[if] pc from decode: pc now %x\n", window_pc.u);
+			redirect = curr->pc_decode_predict;
+			tracei("[if] pc from decode: pc now %x\n", redirect.u);
 		}
-		else if (curr->decode_is_clear) {
-			/* 4) Fetch (btac) branch prediction (JAL, JALR, CMP), or pc+4 */
-			window_pc = curr->pc_fetch;
-			tracei("[if] pc from fetch %x\n", window_pc.u);
+		/* Everything queued up is younger than whatever redirected us,
+		 * decode gets nothing this cycle. */
+		const bool fetch_flushed = redirect.u || fetch_hold || curr->decode_drop_next;
+		if (fetch_flushed) {
+			fetch_flush(&next->ftq, &next->fetch_buf);
+			next->pc_fetch = redirect;
 		}
-		else {
-			/* If we decode hasn't handled last time's instructions, just send the same again. */
-			window_pc = curr->pc_last;
-			tracei("[if] pc wait for decode congestion %x\n", window_pc.u);
+		/* 4) Predict. The BTAC picks where each block ends and where it
+		 * goes. It has a port per block, so it follows up to
+		 * opt_fetch_taken taken branches for a fetch width of
+		 * instructions a cycle, up to FTQ_SIZE blocks ahead of fetch. */
+		for (size_t n = 0, taken = 0; next->pc_fetch.u && ftq_count(&next->ftq) < FTQ_SIZE
+				&& n < ISSUE_WIDTH && taken <= opt_fetch_taken; ) {
+			word_u taddr = { 0 };
+			const size_t hit = btac_lookup(&curr->btac, next->pc_fetch, ISSUE_WIDTH, &taddr);
+			const struct fetch_block block = {
+				.pc = next->pc_fetch,
+				.count = hit < ISSUE_WIDTH ? hit + 1 : ISSUE_WIDTH,
+				.btac_hit = hit < ISSUE_WIDTH,
+				.btac_taddr = taddr,
+			};
+			ftq_push(&next->ftq, &block);
+			next->pc_fetch = block.btac_hit ? taddr
+				: (word_u) { .u = block.pc.u + block.count * 4 };
+			tracei("[if] predict block %x+%lu, then %x\n", block.pc.u, block.count, next->pc_fetch.u);
+			n += block.count;
+			taken += block.btac_hit;
 		}
-		if (window_pc.u) {
-			next->pc_last = window_pc;
-			next->pc_fetch = (word_u) { .u = window_pc.u + ISSUE_WIDTH * 4 };
+		/* 5) Fetch a fetch width of instructions from the oldest blocks,
+		 * again past up to opt_fetch_taken taken branches. What's left
+		 * of a block waits for next cycle. */
+		size_t fetched = 0;
+		for (size_t taken = 0; ftq_count(&next->ftq) && fetched < ISSUE_WIDTH
+				&& taken <= opt_fetch_taken; ) {
+			struct fetch_block *block = ftq_oldest(&next->ftq);
+			size_t n = block->count;
+			if (n > ISSUE_WIDTH - fetched)
+				n = ISSUE_WIDTH - fetched;
+			if (FETCH_BUF_SIZE - fetch_buf_count(&next->fetch_buf) < n) {
+				tracei("[if] fetch buffer full\n");
+				if (!fetched)
+					next->stats.fetch_buf_full++;
+				break;
+			}
 			size_t i;
-			for (i = 0; i < ISSUE_WIDTH; i++) {
-				const word_u pc = (word_u) { .u = window_pc.u + i * 4 };
+			for (i = 0; i < n; i++) {
+				const word_u pc = (word_u) { .u = block->pc.u + i * 4 };
+				const bool last = i + 1 == block->count;
 				bool exception = false;
-				next->fetch_window[i] = (fetched_instr_t) {
+				const fetched_instr_t instr = {
 					.pc = pc,
 					.instr = memory_op(mem, LSU_OP_LW, pc, (word_u){ .u = 0 }, &exception),
-					.btac = curr->btac.buffer[(pc.u / 4) & BTAC_INDEX_MASK],
-					.bht = curr->bht.buffer[bht_index(pc, curr->global_branch_history)],
+					.btac_hit = last && block->btac_hit,
+					.btac_taddr = last && block->btac_hit ? block->btac_taddr : (word_u){ 0 },
 				};
 				if (exception) {
 					printf("[warn] Exception on fetch, hope we're speculating. Stalling.\n");
-					next->pc_fetch.u = 0u;
-					break;
-				}
-				// In HW we just calculate first BTAC hit in next cycle, and ignore later instrs in decode.
-				// Here, break to make debugging easier.
-				if (next->fetch_window[i].btac.br_pc.u == pc.u) {
-					next->pc_fetch = next->fetch_window[i].btac.taddr;
 					break;
 				}
+				fetch_buf_push(&next->fetch_buf, &instr);
 			}
+			fetched += i;
+			if (i < n) {
+				/* Nothing more until something redirects us. */
+				next->ftq.tail = next->ftq.head;
+				next->pc_fetch.u = 0;
+				break;
+			} else if (n < block->count) {
+				block->pc.u += n * 4;
+				block->count -= n;
+			} else {
+				taken += block->btac_hit;
+				ftq_pop(&next->ftq);
+			}
+		}
+		if (fetched) {
 			next->stats.fetch_window_cnt++;
-			next->stats.fetch_window_sum += i;
+			next->stats.fetch_window_sum += fetched;
 		}
 
 		/* Decode/issue. 
 		 * Mostly: find free RS and ROB, occupies them.
-		 * Also branch prediction / jump handling. */
-		fetched_instr_t decode_window[ISSUE_WIDTH] = { 0 };
-		next->decode_is_clear = 1;
+		 * Also branch prediction / jump handling.
+		 * Takes up to ISSUE_WIDTH from the fetch buffer, what it can't
+		 * issue waits there. */
+		fetched_instr_t decode_window[ISSUE_WIDTH];
+		size_t decode_n = 0;
 		if (curr->decode_drop_next) {
 			tracei("[id] Got signal to drop next.\n");
 		} else if (curr->pc_rob_mispredict.u) {
 			tracei("[id] ROB mispredict, id drop fetched\n");
 		} else if (curr->pc_decode_predict.u) {
 			tracei("[id] BTAC miss but branch predicted, id drop fetched.\n");
-//			assert(!curr->id_hold.instr.u);
-		} else if (!curr->decode_is_clear) {
-			tracei("[id] using held instr(s)\n");
-			for (size_t i = 0; i < ISSUE_WIDTH; i++) {
-				decode_window[i] = curr->held_window[i];
-			}
-		} else {
-			for (size_t i = 0; i < ISSUE_WIDTH; i++) {
-				decode_window[i] = curr->fetch_window[i];
-			}
+		} else if (!fetch_flushed) {
+			decode_n = fetch_buf_count(&curr->fetch_buf);
+			if (decode_n > ISSUE_WIDTH)
+				decode_n = ISSUE_WIDTH;
+			for (size_t i = 0; i < decode_n; i++)
+				decode_window[i] = *fetch_buf_at(&curr->fetch_buf, i);
 		}
-
-		next->ldb_head = curr->ldb_head;
-		for (size_t i = 0; i < ISSUE_WIDTH; i++) {
-			const fetched_instr_t instr = decode_window[i];
+		if (!decode_n)
+			next->stats.decode_starved++;
+		size_t decoded = decode_n;
+
+		for (size_t i = 0; i < decode_n; i++) {
+			/* A fused pair goes down as its first instruction, or as a
+			 * JAL for a call. */
+			const enum fuse_idiom fuse = i + 1 < decode_n
+				? fuse_match(&decode_window[i], &decode_window[i + 1]) : FUSE_NONE;
+			const fetched_instr_t *const fuse_b = &decode_window[i + 1];
+			const fetched_instr_t instr = fuse == FUSE_AUIPC_JALR ? *fuse_b : decode_window[i];
 
 			tracei("[id] pc %x have instr %x ", instr.pc.u, instr.instr.u);
-			const uint32_t opcode = instr_opcode(instr.instr).u;
+			if (fuse != FUSE_NONE)
+				tracei("fused %s with %x ", fuse_idiom_str(fuse), fuse_b->instr.u);
+			const uint32_t opcode = fuse == FUSE_AUIPC_JALR ? OPC_JAL
+				: instr_opcode(instr.instr).u;
 			const uint32_t funct3 = instr_funct3(instr.instr).u;
 			//const uint32_t funct7 = instr_funct7(id_instr).u;
 			const uint8_t rs1 = instr_rs1(instr.instr);
@@ -387,11 +456,10 @@ int main(int argc, char **argv)
 			rs_find_free(curr, next, &rs, &new_rs);
 
 			rob_t *const new_rob = rob_find_free(curr, next);
+			const bool have_preg = prf_can_rename(next->prf);
 
 			bool hold_remaining = false;
-			const bool btac_hit = (instr.pc.u == instr.btac.br_pc.u);
-
-			assert(!next->ras.cmd || !opcode);
+			const bool btac_hit = instr.btac_hit;
 
 			next->stats.issued++;
 			if (per_pc_stats)
@@ -405,8 +473,7 @@ int main(int argc, char **argv)
 				 * Will be executed only when any dependent stores are retired. */
 				tracei("(load)\n");
 
-				if (new_ldb && new_rob) {
-					ldb_alloc(curr, next, new_ldb);
+				if (new_ldb && new_rob && have_preg) {
 					rs_rob_alloc(curr, next, new_ldb, new_rob, ROB_INSTR_REGISTER, RS_LOAD,
 						instr.pc, instr_lsu_op(opcode, funct3));
 					rs_set_rsrc1(new_ldb, rs1, next);
@@ -416,6 +483,12 @@ int main(int argc, char **argv)
 					tracei("[id] put in rob %lu", new_ldb->rob_id);
 
 					new_rob->dbg_was_load = 1;
+					/* In case we have to replay it. */
+					new_rob->branch_ctrl.hist = next->bpred_hist;
+					new_rob->branch_ctrl.ras = ras_checkpoint(&next->ras);
+					new_ldb->stq_id = next->stq.head;
+					new_ldb->stq_dep = feature_storeset ?
+						storeset_load_dep(&next->storeset, instr.pc) : STQ_SIZE;
 					new_ldb->immediate = instr_imm_itype(instr.instr);
 					if (new_ldb->qj == 0) {
 						new_ldb->addr.u = new_ldb->vj.u + new_ldb->immediate.u;
@@ -429,7 +502,7 @@ int main(int argc, char **argv)
 						new_ldb->addr.u = 0;
 					}
 
-					rob_rd(next, new_rob, rd);
+					new_ldb->dest = rob_rd(next, new_rob, rd);
 				} else {
 					tracei("[id] no free ldb or rob\n");
 					hold_remaining = 1;
@@ -441,10 +514,13 @@ int main(int argc, char **argv)
 				tracei("(store)\n");
 
 				/* FIXME: if op1, op2 are already available. */
-				if (rs && new_rob) {
+				if (rs && new_rob && stq_find_free(&curr->stq, &next->stq)) {
   					rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_STORE, RS_STORE,
 							instr.pc, (word_u)1u);
 					new_rob->store_op = instr_lsu_op(opcode, funct3).u;
+					new_rs->stq_id = stq_alloc(&curr->stq, &next->stq,
+							new_rob->id, instr.pc, new_rob->store_op);
+					storeset_store_fetched(&next->storeset, instr.pc, new_rs->stq_id);
 					rs_set_rsrc1(new_rs, rs1, next);
 					rs_set_rsrc2(new_rs, rs2, next);
 
@@ -456,11 +532,14 @@ int main(int argc, char **argv)
 						if (!new_rs->addr.u) {
 							new_rs->addr.u = 0xFFffFFff;	
 						}
+						stq_set_addr(&next->stq, new_rs->stq_id, new_rs->addr);
 					} else {
 						new_rs->addr.u = 0;
 					}
+					if (new_rs->qk == 0)
+						stq_set_val(&next->stq, new_rs->stq_id, new_rs->vk);
 				} else {
-					tracei("[id] no free rs\n");
+					tracei("[id] no free rs/stq\n");
 					hold_remaining = 1;
 				}
 			}
@@ -471,10 +550,26 @@ int main(int argc, char **argv)
 					break;
 				}
 				tracei("(reg-reg)\n");
+				/* xor or sub of a register with itself is 0. */
+				const bool zero = feature_move_elim && rs1 == rs2 && !instr_is_mdu(instr.instr)
+					&& (instr_alu_op(instr.instr) == ALU_OP_XOR
+						|| instr_alu_op(instr.instr) == ALU_OP_SUB);
 
-				if (rs && new_rob) {
-					rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_REGISTER, RS_ALU,
+				if (zero && new_rob && have_preg) {
+					rob_alloc_only(curr, next, new_rob, ROB_INSTR_REGISTER, instr.pc);
+					rob_rd(next, new_rob, rd);
+					rob_rd_ready(next, new_rob, (word_u){ .u = 0 });
+					next->stats.elim_zero++;
+				} else if (rs && new_rob && have_preg) {
+					if (instr_is_mdu(instr.instr)) {
+						const enum mdu_op op = instr_mdu_op(instr.instr);
+						rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_REGISTER,
+							mdu_op_class(op) == FU_MUL ? RS_MUL : RS_DIV,
+							instr.pc, (word_u){ .u = op });
+					} else {
+						rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_REGISTER, RS_ALU,
 							instr.pc, (word_u){ .u = instr_alu_op(instr.instr) });
+					}
 					rs_set_rsrc1(new_rs, rs1, next);
 					rs_set_rsrc2(new_rs, rs2, next);
 
@@ -482,7 +577,7 @@ int main(int argc, char **argv)
 
 					new_rs->addr.u = new_rs->immediate.u = 0;
 
-					rob_rd(next, new_rob, rd);
+					new_rs->dest = rob_rd(next, new_rob, rd);
 				} else {
 					tracei("[id] no free rs\n");
 					hold_remaining = 1;
@@ -495,8 +590,42 @@ int main(int argc, char **argv)
 					break;
 				}
 				tracei("(reg-imm)\n");
+				/* addi from x0 is a constant, and addi of 0 a move: rd
+				 * just takes the source's register. */
+				const word_u imm = instr_imm_itype(instr.instr);
+				const bool addi = feature_move_elim && funct3 == 0;
+				const bool constant = addi && !rs1;
+				const bool move = addi && rs1 && !imm.u;
+
+				if (constant && new_rob && have_preg) {
+					rob_alloc_only(curr, next, new_rob, ROB_INSTR_REGISTER, instr.pc);
+					rob_rd(next, new_rob, rd);
+					rob_rd_ready(next, new_rob, imm);
+					if (imm.u)
+						next->stats.elim_const++;
+					else
+						next->stats.elim_zero++;
+				} else if (move && new_rob) {
+					rob_alloc_only(curr, next, new_rob, ROB_INSTR_REGISTER, instr.pc);
+					rob_rd_alias(next, new_rob, rd, rs1);
+					next->stats.elim_move++;
+				} else if (rs && new_rob && have_preg && fuse == FUSE_SLLI_ADD) {
+					/* The add's other source goes in shifted by the slli's
+					 * amount. */
+					const uint8_t rt = instr_rs1(fuse_b->instr) == rd
+						? instr_rs2(fuse_b->instr) : instr_rs1(fuse_b->instr);
+					rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_REGISTER, RS_ALU,
+						instr.pc, (word_u){ .u = ALU_OP_SHADD });
+					rs_set_rsrc1(new_rs, rs1, next);
+					rs_set_rsrc2(new_rs, rt, next);
 
-				if (rs && new_rob) {
+					tracei("[id] put in rob id %lu for reg %s\n", new_rob->id, reg_name(rd));
+
+					new_rs->addr.u = 0;
+					new_rs->immediate.u = instr_imm_itype(instr.instr).u & 0x1F;
+
+					new_rs->dest = rob_rd(next, new_rob, rd);
+				} else if (rs && new_rob && have_preg) {
 					rs_rob_alloc
 					(
 					 	curr, next, new_rs, new_rob,
@@ -512,7 +641,7 @@ int main(int argc, char **argv)
 				        new_rs->vk = instr_imm_itype(instr.instr);
 					new_rs->addr.u = new_rs->immediate.u = 0;
 
-					rob_rd(next, new_rob, rd);
+					new_rs->dest = rob_rd(next, new_rob, rd);
 				} else {
 					tracei("[id] no free rs\n");
 					hold_remaining = 1;
@@ -526,14 +655,14 @@ int main(int argc, char **argv)
 				}
 				tracei("(auipc)\n");
 
-				if (new_rob) {
+				if (new_rob && have_preg) {
 					/* Assume we can do pc + imm in decode (this is needed
 					 * for auipc, branch, jal, so not too far fetched) */
 					rob_alloc_only(curr, next, new_rob, ROB_INSTR_REGISTER, instr.pc);
 					rob_rd(next, new_rob, rd);
-					rob_ready(new_rob, (word_u){ 
-						.u = instr.pc.u + instr_imm_utype(instr.instr).u
-					});
+					rob_rd_ready(next, new_rob, fuse == FUSE_AUIPC_ADDI
+						? fuse_value(fuse, &instr, fuse_b)
+						: (word_u){ .u = instr.pc.u + instr_imm_utype(instr.instr).u });
 				} else {
 					tracei("[id] no free rob\n");
 					hold_remaining = 1;
@@ -545,10 +674,12 @@ int main(int argc, char **argv)
 				tracei("(lui) -- doing wb.\n");
 				if (rd == 0) {
 					// nop
-				} else if (new_rob) {
+				} else if (new_rob && have_preg) {
 					rob_alloc_only(curr, next, new_rob, ROB_INSTR_REGISTER, instr.pc);
 					rob_rd(next, new_rob, rd);
-					rob_ready(new_rob, instr_imm_utype(instr.instr));
+					rob_rd_ready(next, new_rob, fuse == FUSE_LUI_ADDI
+						? fuse_value(fuse, &instr, fuse_b)
+						: instr_imm_utype(instr.instr));
 				} else {
 					tracei("[id] no free ROB\n");
 					hold_remaining = 1;
@@ -567,8 +698,16 @@ int main(int argc, char **argv)
 					 * - If BTAC missed, but we predict a branch, drop next decode
 					 *   and send proper prediction back to fetch. */
 					bool p;
+					enum bpred_dir dir = bpred_predict(next->bpred, &next->bpred_hist, instr.pc);
+					bool loop_taken;
+					new_rob->branch_ctrl.backward = instr_imm_btype(instr.instr).s < 0;
+					if (feature_loop && !opt_nospec && loop_predict(next->loop, instr.pc, &loop_taken)) {
+						const enum bpred_dir ldir = loop_taken ? BPRED_TAKEN : BPRED_NOT_TAKEN;
+						new_rob->branch_ctrl.loop = ldir == dir ? ROB_LOOP_AGREE : ROB_LOOP_OVERRIDE;
+						dir = ldir;
+					}
 					if (btac_hit) {
-						if (instr.bht.valid && instr.bht.ctr < 2) {
+						if (dir == BPRED_NOT_TAKEN) {
 							tracei("BTAC hit but bht predicts not taken\n");
 							p = 0;
 							new_rob->dbg_branch_info.pred = ROB_PRED_BHT;
@@ -577,10 +716,15 @@ int main(int argc, char **argv)
 							tracei("btac hit %x\n", taddr.u);
 							new_rob->dbg_branch_info.pred = ROB_PRED_BTAC;
 							p = 1;
+							/* Partial tag matched another branch's entry. */
+							if (instr.btac_taddr.u != taddr.u) {
+								next->stats.btac_alias++;
+								next->pc_decode_predict = taddr;
+							}
 						}
 					} else {
-					       	if (instr.bht.valid) {
-							p = instr.bht.ctr > 1;
+					       	if (dir != BPRED_NONE) {
+							p = dir == BPRED_TAKEN;
 							new_rob->dbg_branch_info.pred = ROB_PRED_BHT;
 						} else {
 							p = instr_imm_btype(instr.instr).s < 0;
@@ -588,6 +732,7 @@ int main(int argc, char **argv)
 						}
 						if (p) {
 							tracei("pred taken\n");
+							btac_count_miss(curr, next, instr.pc);
 							next->pc_decode_predict = taddr;
 						} else {
 							tracei("pred not taken\n");
@@ -596,11 +741,14 @@ int main(int argc, char **argv)
 
 					rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_BRANCH, RS_BR,
 							instr.pc, (word_u) { .u = BRU_OP_SET | funct3 });
+					rob_mask_set(&next->rob_cond, new_rob->id - 1);
 					rs_set_rsrc1(new_rs, rs1, next);
 					rs_set_rsrc2(new_rs, rs2, next);
 
 					new_rs->immediate = taddr;
-					next->global_branch_history = (curr->global_branch_history << 1) | p;
+					bpred_spec_update(next->bpred, &next->bpred_hist, instr.pc, p);
+					if (feature_loop)
+						loop_spec_update(next->loop, instr.pc, p);
 					if (p) {
 						new_rs->predicted_taddr = new_rob->data.brt.pred = taddr;
 					} else {
@@ -633,7 +781,7 @@ int main(int argc, char **argv)
 				tracei("(jal)");
 				if (rs && new_rob) {
 					const bool two = ((next->rob_head + 2) & ROB_INDEX_MASK) != curr->rob_tail;
-					if (rd != 0 && !two) {
+					if (rd != 0 && (!two || !have_preg)) {
 						goto jal_alloc_fail;
 					}
 
@@ -647,18 +795,21 @@ int main(int argc, char **argv)
 						assert(rob_two != new_rob);
 						rob_alloc_only(curr, next, rob_two, ROB_INSTR_REGISTER, instr.pc);
 						rob_rd(next, rob_two, rd);
-						rob_ready(rob_two, (word_u) { .u = instr.pc.u + 4 });
+						rob_rd_ready(next, rob_two, (word_u) { .u = instr.pc.u + 4 });
 					}
 					tracei("\n");
 					/* If BTAC hit, then fetch is already in right place.
 					 * Otherwise, pass back correct target. */
-					const word_u target = (word_u) {
-						.u = instr_imm_jtype(instr.instr).u + instr.pc.u
-					};
-					if (btac_hit) {
-						assert(instr.btac.taddr.u == target.u);
+					const word_u target = fuse == FUSE_AUIPC_JALR
+						? fuse_value(fuse, &decode_window[i], fuse_b)
+						: (word_u) { .u = instr_imm_jtype(instr.instr).u + instr.pc.u };
+					if (btac_hit && instr.btac_taddr.u == target.u) {
 						new_rob->dbg_branch_info.pred = ROB_PRED_BTAC;
 					} else {
+						if (btac_hit)
+							next->stats.btac_alias++;
+						else
+							btac_count_miss(curr, next, instr.pc);
 						next->pc_decode_predict = target;
 						new_rob->dbg_branch_info.pred = ROB_PRED_NONE;
 					}
@@ -666,13 +817,13 @@ int main(int argc, char **argv)
 					new_rob->branch_ctrl.consider_prediction = b_set(0);
 					new_rob->branch_ctrl.change_bht = b_set(0);
 					new_rob->dbg_branch_info.type = ROB_BRANCH_JAL;
-					rob_ready(new_rob, target);
+					rob_ready(next, new_rob, target);
 
 					if (is_link_reg(rd) && !opt_nospec) {
-						next->ras.cmd = RAS_PUSH;
-						next->ras.arg.u = instr.pc.u + 4;
+						if (ras_push(&next->ras, (word_u){ .u = instr.pc.u + 4 }))
+							next->stats.ras_overflow++;
 						if (opt_clearhistoncall)
-							next->global_branch_history = 0;
+							bpred_hist_reset(&next->bpred_hist);
 					}
 				} else {
 				jal_alloc_fail:
@@ -685,7 +836,7 @@ int main(int argc, char **argv)
 				tracei("(jalr) ");
 				if (rs && new_rob) {
 					const bool two = ((next->rob_head + 2) & ROB_INDEX_MASK) != curr->rob_tail;
-					if (rd != 0 && !two) {
+					if (rd != 0 && (!two || !have_preg)) {
 						goto jalr_alloc_fail;
 					}
 					/* BRU on JALR will take the target address as 
@@ -694,30 +845,52 @@ int main(int argc, char **argv)
 					rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_BRANCH, RS_BR,
 						instr.pc, (word_u){ .u = BRU_OP_JALR_TO_FETCH });
 					new_rob->dbg_branch_info.type = ROB_BRANCH_JALR;
-					if (!is_link_reg(rd) && is_link_reg(rs1) && curr->ras.head.u) {
-						/* Always pop off stack,
-						 * if BTAC missed/mispredicted, pass back correct PC. */
-						next->ras.cmd = RAS_POP;
-						new_rs->predicted_taddr = new_rob->data.brt.pred =
-							curr->ras.head;
+					/* Hints from the Unpriv Spec, 2.5: return, call, or
+					 * both (coroutine swap). */
+					const bool ret = is_link_reg(rs1) && (!is_link_reg(rd) || rd != rs1);
+					const bool call = is_link_reg(rd);
+					const word_u ret_addr = ret ? ras_top(&next->ras) : (word_u){ 0 };
+					if (!opt_nospec) {
+						if (ret && !ras_pop(&next->ras))
+							next->stats.ras_underflow++;
+						if (call && ras_push(&next->ras, (word_u){ .u = instr.pc.u + 4 }))
+							next->stats.ras_overflow++;
+					}
+					new_rob->branch_ctrl.ras = ras_checkpoint(&next->ras);
+					new_rob->branch_ctrl.indirect = !ret;
+					word_u itarget;
+					if (ret_addr.u && !opt_nospec) {
+						/* If BTAC missed/mispredicted, pass back correct PC. */
+						new_rs->predicted_taddr = new_rob->data.brt.pred = ret_addr;
 						new_rs->op.u = BRU_OP_JALR_TO_ROB;
-						if (curr->ras.head.u != instr.btac.taddr.u)
-							next->pc_decode_predict = curr->ras.head;
+						if (!btac_hit || ret_addr.u != instr.btac_taddr.u)
+							next->pc_decode_predict = ret_addr;
 
 						new_rob->branch_ctrl.change_bht = b_set(0);
 						new_rob->branch_ctrl.consider_prediction = b_set(1);
 						new_rob->dbg_branch_info.pred = ROB_PRED_RAS;
 						tracei("ras hit.\n");
+					} else if (feature_ittage && !opt_nospec
+							&& ittage_predict(next->ittage, &next->bpred_hist, instr.pc, &itarget)) {
+						tracei("indirect predictor hit.\n");
+						new_rs->predicted_taddr = new_rob->data.brt.pred = itarget;
+						new_rs->op.u = BRU_OP_JALR_TO_ROB;
+						if (!btac_hit || instr.btac_taddr.u != itarget.u)
+							next->pc_decode_predict = itarget;
+						new_rob->branch_ctrl.change_bht = b_set(0);
+						new_rob->branch_ctrl.consider_prediction = b_set(1);
+						new_rob->dbg_branch_info.pred = ROB_PRED_INDIRECT;
 					} else if (btac_hit) {
 						tracei("btac hit.\n");
 						new_rs->predicted_taddr = new_rob->data.brt.pred =
-							instr.btac.taddr;
+							instr.btac_taddr;
 						new_rs->op.u = BRU_OP_JALR_TO_ROB;
 						new_rob->branch_ctrl.change_bht = b_set(0);
 						new_rob->branch_ctrl.consider_prediction = b_set(1);
 						new_rob->dbg_branch_info.pred = ROB_PRED_BTAC;
 					} else {
 						tracei("btac miss.\n");
+						btac_count_miss(curr, next, instr.pc);
 						/* Otherwise, we have no idea where to go next,
 						 * stall fetch and decode until the branch unit lets fetch know */
 						next->decode_drop_next = 1;
@@ -736,7 +909,8 @@ int main(int argc, char **argv)
 						assert(rob_two != new_rob);
 						rob_alloc_only(curr, next, rob_two, ROB_INSTR_REGISTER, instr.pc);
 						rob_rd(next, rob_two, rd);
-						rob_ready(rob_two, (word_u) { .u = instr.pc.u + 4 });
+						rob_rd_ready(next, rob_two, (word_u) { .u = instr.pc.u + 4 });
+						new_rob->branch_ctrl.rename = prf_checkpoint(next->prf);
 					}
 				} else {
 				jalr_alloc_fail:
@@ -755,7 +929,7 @@ int main(int argc, char **argv)
 				case 0x0:
 					assert(0 && "Ecall not implemented"); 
 				case 0x100000:
-					if (rs && new_rob) {
+					if (rs && new_rob && have_preg) {
 						rs_rob_alloc(curr, next, new_rs, new_rob, ROB_INSTR_DEBUG, RS_DBG,
 							instr.pc, (word_u)1u);
 						/* Reg according to our peverse calling convention. */
@@ -779,7 +953,7 @@ int main(int argc, char **argv)
 				if (new_rob) {
 					tracei("(invalid)\n");
 					rob_alloc_only(curr, next, new_rob, ROB_INSTR_DEBUG, instr.pc);
-					new_rob->ready = 1;
+					rob_set_ready(next, new_rob);
 					new_rob->exception = 1;
 					fprintf(stderr, "[decode] Warn unknown instr 0x%x at PC %x\n", instr.instr.u, instr.pc.u);
 				} else {
@@ -788,71 +962,136 @@ int main(int argc, char **argv)
 				}
 			}
 
+			if (fuse != FUSE_NONE && !hold_remaining) {
+				new_rob->fused = 1;
+				next->stats.fused[fuse]++;
+				next->stats.issued++;
+				i++;
+			}
+
+			/* Fetch went off to a BTAC target after an instruction that
+			 * doesn't branch. */
+			if (btac_hit && !hold_remaining && opcode != OPC_BRANCH
+					&& opcode != OPC_JAL && opcode != OPC_JALR) {
+				next->stats.btac_alias++;
+				next->pc_decode_predict.u = instr.pc.u + 4;
+			}
+
 			if (hold_remaining) {
 				assert(!next->pc_decode_predict.u);
-				next->decode_is_clear = 0;
-				tracei("[id] holding from %d\n", i);
-				for (size_t j = i; j < ISSUE_WIDTH; j++) {
-					next->held_window[j - i] = decode_window[j];
-				}
+				next->stats.stall_prf += !have_preg;
+				tracei("[id] holding from %lu\n", i);
+				decoded = i;
 				break;
 			} else if (next->pc_decode_predict.u || next->fetch_wait_jalr_bru) {
+				decoded = i + 1;
 				break;
 			}
 		}
+		/* Unless fetch was redirected, in which case it's empty anyway. */
+		if (!fetch_flushed)
+			fetch_buf_pop(&next->fetch_buf, decoded);
+		next->stats.fetch_buf_sum += fetch_buf_count(&next->fetch_buf);
+		next->stats.ftq_sum += ftq_count(&next->ftq);
 
 		cdb_clear(&next->cdb);
 
-		/* RAS */
-		ras_do(&curr->ras, &next->ras);
-
 /* Exec. */
 		/* One loop per unit - correspoding to an RS_ type. */
-		for (size_t i = 0; i < ALU_COUNT; i++) {
-			const alu_t *alu = &curr->alus[i];
-			alu_t *new = &next->alus[i];
+		/* ALU, MUL and DIV results due this cycle go on the CDB.
+		 * A unit whose result doesn't get on takes no new op. */
+		bool fu_held[FU_COUNT] = { 0 };
+		const struct fu_event *ev;
+		while ((ev = fu_events_due(&next->fu_events, curr->clk))) {
 			cdb_entry *cdb = cdb_find_free(&next->cdb);
-			if (!alu->rob_id || cdb) {
-				const rs_t *rs = rs_waiting_and_free(curr, next, RS_ALU);
-				if (rs) {
-					tracei("[alu] have instr from %lu\n", rs->rob_id);
-					*new = (alu_t) {
-						.op = rs->op.u,
-						.op1 = rs->vj,
-						.op2 = rs->vk,
-						.rob_id = rs->rob_id,
-						.clk_start = curr->clk,
-					};
-				} else {
-					tracei("[alu] nothing to fetch.\n");
-				}
-			}
-		       	if (alu->rob_id) {
-				if (cdb) {
-					cdb->rob_id = alu->rob_id;
-					cdb->data = alu_result(alu);
-					tracei("[alu] put result (%u %x) into cdb with tag %lu\n",
-							cdb->data.u, cdb->data.u, alu->rob_id);
-				} else {
-					tracei("[alu] stall waiting for cdb with tag %lu\n", alu->rob_id);
+			if (!cdb) {
+				for (size_t i = 0; i < next->fu_events.count; i++) {
+					ev = &next->fu_events.ev[i];
+					if (ev->due > curr->clk)
+						break;
+					tracei("[fu] stall waiting for cdb with tag %lu\n", ev->rob_id);
 					next->stats.wait_cdb++;
-					*new = *alu;
+					fu_held[ev->unit] = 1;
 				}
+				break;
 			}
+			cdb->rob_id = ev->rob_id;
+			cdb->preg = ev->dest;
+			cdb->data = ev->data;
+			tracei("[fu] put result (%u %x) into cdb with tag %lu\n",
+					cdb->data.u, cdb->data.u, ev->rob_id);
+			fu_events_pop(&next->fu_events);
 		}
-		next->ldb_tail = curr->ldb_tail;
+		for (size_t i = 0; i < FU_COUNT; i++) {
+			if (fu_held[i] || curr->clk < curr->fu_next_issue[i]
+					|| fu_events_full(&next->fu_events))
+				continue;
+			const enum rs_type type = i < ALU_COUNT ? RS_ALU
+				: i < ALU_COUNT + MUL_COUNT ? RS_MUL : RS_DIV;
+			const rs_t *rs = rs_waiting_and_free(curr, next, type);
+			if (!rs) {
+				tracei("[fu] %s %lu nothing to fetch.\n", rs_type_str(type), i);
+				continue;
+			}
+			tracei("[fu] %s %lu have instr from %lu\n", rs_type_str(type), i, rs->rob_id);
+			struct fu_event new = {
+				.unit = i,
+				.rob_id = rs->rob_id,
+				.dest = rs->dest,
+			};
+			size_t latency, interval;
+			if (type == RS_ALU) {
+				const alu_t alu = {
+					.op = rs->op.u,
+					.op1 = rs->vj,
+					.op2 = rs->vk,
+					.rob_id = rs->rob_id,
+					.dest = rs->dest,
+					.shamt = rs->immediate.u,
+					.clk_start = curr->clk,
+				};
+				const struct fu_timing *t = &fu_timing[alu_op_class(alu.op)];
+				latency = t->latency;
+				interval = t->interval;
+				new.data = alu_result(&alu);
+			} else {
+				const mdu_t mdu = {
+					.op = rs->op.u,
+					.op1 = rs->vj,
+					.op2 = rs->vk,
+					.rob_id = rs->rob_id,
+					.dest = rs->dest,
+					.clk_start = curr->clk,
+				};
+				latency = mdu_latency(&mdu);
+				interval = type == RS_DIV ? latency : fu_timing[FU_MUL].interval;
+				new.data = mdu_result(&mdu);
+			}
+			next->fu_next_issue[i] = curr->clk + interval;
+			new.due = curr->clk + latency;
+			fu_events_push(&next->fu_events, &new);
+		}
+		size_t lsus_free = 0;
+		for (size_t i = 0; i < LSU_COUNT; i++)
+			lsus_free += !curr->lsus[i].rob_id;
+		const rs_t *issue[LSU_COUNT];
+		const size_t issue_cnt = ldb_next_and_free(curr, next, issue, lsus_free);
+		size_t issue_i = 0;
 		for (size_t i = 0; i < LSU_COUNT; i++) {
 			const lsu_t *lsu = &curr->lsus[i];
 			lsu_t *new = &next->lsus[i];
 			if (!lsu->rob_id) {
-				const rs_t *ldb = ldb_next_and_free(curr, next);
-				if (ldb) {
+				if (issue_i < issue_cnt) {
+					const rs_t *ldb = issue[issue_i++];
 					tracei("[ldb] has op from ldb (%lu)\n", ldb->rob_id);
 					*new = (lsu_t) {
 						.op = ldb->op.u,
 						.addr = ldb->addr,
 						.rob_id = ldb->rob_id,
-						.clk_start = (curr->clk + rand()) & 3,
+						.dest = ldb->dest,
+						.stq_pos = ldb->stq_id,
+						.stq_dep = ldb->stq_dep,
+						.clk_start = curr->clk + (rng_next(&next->rng) & 3),
 						.data_in = ldb->vk,
 					};
 				} else {
@@ -862,6 +1101,7 @@ int main(int argc, char **argv)
 				cdb_entry *cdb = cdb_find_free(&next->cdb);
 				if (cdb) {
 					cdb->rob_id = lsu->rob_id;
+					cdb->preg = lsu->dest;
 					cdb->exception = lsu->exception;
 					cdb->data = lsu->data_out;
 					tracei("[ldb] addr %x put result (%u %x) on cdb with tag %lu\n",
@@ -873,19 +1113,21 @@ int main(int argc, char **argv)
 				}
 			} else {
 				*new = *lsu;
-				bool have_val = false, wait_val = false;
-				word_u val;
-				bool overlap = rob_earlier_store_overlaps(curr, lsu, &val, &have_val, &wait_val);
-				if (have_val && feature_store_forward) {
-					tracei("[ldb] result forwarded from store.\n");
-					new->data_out_set = 1;
-					new->data_out = val;
-				} else if (overlap) {
-					if (wait_val)
+				struct stq_fwd fwd;
+				stq_forward(&curr->stq, lsu->stq_pos, lsu->op, lsu->addr,
+					load_wait_unknown(lsu->stq_dep), &fwd);
+				const uint8_t all = (1u << lsu_op_bytes(lsu->op)) - 1;
+				if (fwd.wait || (fwd.mask && !feature_store_forward)) {
+					if (fwd.wait_val)
 						next->stats.wait_store_data++;
 					else
 						next->stats.wait_store_addr++;
 					tracei("[ldb] stall waiting for earlier store\n");
+				} else if (fwd.mask == all) {
+					tracei("[ldb] result forwarded from store.\n");
+					new->data_out_set = 1;
+					new->data_out = fwd.val;
+					next->stats.forward_full++;
 				} else if (lsu->clk_start + 2 < curr->clk) {
 					tracei("[ldb] Fetch result from mem.\n");
 					new->data_out_set = true;
@@ -893,8 +1135,27 @@ int main(int argc, char **argv)
 						new->exception = 1;
 					} else {
 						new->data_out = memory_op(mem, lsu->op, lsu->addr, lsu->data_in, &new->exception);
+						if (fwd.mask) {
+							tracei("[ldb] merging bytes %x from stores\n", fwd.mask);
+							new->data_out = stq_fwd_merge(&fwd, new->data_out);
+							next->stats.forward_partial++;
+						}
 					}
 				}
+				/* Took a value while a store that may alias had no address:
+				 * check it when the store's address arrives. */
+				if (new->data_out_set && fwd.bypassed && !opt_nostorechk) {
+					tracei("[ldb] load %lu went past a store with unknown address\n", lsu->rob_id);
+					rob_t *rob = &next->rob[lsu->rob_id - 1];
+					assert(rob->id == lsu->rob_id);
+					rob->load.bypassed = 1;
+					rob_mask_set(&next->rob_bypassed, lsu->rob_id - 1);
+					rob->load.addr = lsu->addr;
+					rob->load.op = lsu->op;
+					next->stats.storeset_bypass++;
+				}
+				if (new->data_out_set && !new->exception)
+					load_order_check(next, lsu->rob_id, lsu->stq_pos, lsu->op, lsu->addr, new->data_out);
 			}
 		}
 		for (size_t i = 0; i < BRU_COUNT; i++) {
@@ -930,12 +1191,17 @@ int main(int argc, char **argv)
 						next->pc_exec_bru = act;
 						tracei("[bru] set pc_exec_bru for JALR\n");
 					}
-					/* Can't do anything about issued instrs yet, but
-					 * might as well stop fetching new ones. */
+					/* Throw away everything younger and refetch, or
+					 * (without early recovery) at least stop fetching
+					 * until the ROB flushes. */
 					if (act.u != bru->predicted_taddr.u && bru->op != BRU_OP_JALR_TO_FETCH && !opt_nospec) {
-						tracei("[bru] stall fetch and decode.\n");
-						next->fetch_wait_rob_mispredict = 1;
-						next->decode_drop_next = 1;
+						if (feature_early_recovery) {
+							branch_recover(curr, next, bru->rob_id, act);
+						} else {
+							tracei("[bru] stall fetch and decode.\n");
+							next->fetch_wait_rob_mispredict = 1;
+							next->decode_drop_next = 1;
+						}
 					}
 				} else {
 					tracei("[bru] stall for cdb\n");
@@ -953,11 +1219,11 @@ int main(int argc, char **argv)
 				rob_t *new_rob = &next->rob[rs->rob_id - 1];
 				assert(new_rob->id == rs->rob_id);
 				assert(rs->addr.u);
-				assert(!new_rob->data.reg.dest.u && !new_rob->ready);
+				assert(!new_rob->data.reg.dest.u);
 				new_rob->data.reg.dest = rs->addr;
 				assert(!rs->qk);
 				new_rob->data.reg.val = rs->vk;
-				new_rob->ready = 1;
+				rob_set_ready(next, new_rob);
 			}
 
 		}
@@ -972,12 +1238,12 @@ int main(int argc, char **argv)
 				assert(new_rob->id == rs->rob_id);
 				new_rob->data.debug.opcode = rs->vj;
 				new_rob->data.debug.operand = rs->vk;
-				new_rob->ready = 1;
+				rob_set_ready(next, new_rob);
 			}
 		}
+		mem_violation_check(next);
 /* Retire */
 		next->btac = curr->btac;
-		next->bht = curr->bht;
 //		memcpy(next->btac, curr->btac, sizeof(curr->btac));
 //		memcpy(next->bht, curr->bht, sizeof(curr->bht));
 
@@ -994,13 +1260,14 @@ int main(int argc, char **argv)
 				break;
 			}
 
-			const rob_t *const entry = &curr->rob[tail];
-			rob_t *const new_entry = &next->rob[tail];
+			/* Our own copy, as a flush clears the ROB under us. */
+			const rob_t retiring = curr->rob[tail];
+			const rob_t *const entry = &retiring;
 			assert(entry->id);
 
 			if (per_pc_stats)
 				per_pc_stats[entry->pc.u].rob_type = entry->type;
-			if (!entry->ready) {
+			if (!rob_mask_test(&curr->rob_ready, tail)) {
 				tracei("[commit] ROB tail not ready\n");
 				next->rob_tail = tail;
 
@@ -1009,12 +1276,27 @@ int main(int argc, char **argv)
 					per_pc_stats[entry->pc.u].retire_stall++;
 				break;
 			}
+			if (entry->load.violation) {
+				tracei("[commit] Load %lu read stale memory -- flush pipeline and replay from %x\n",
+					entry->id, entry->pc.u);
+				next->fetch_wait_rob_mispredict = 1;
+				pipeline_flush(curr, next);
+				flushed = 1;
+				next->stats.flushed += ROB_COUNT(curr);
+				next->pc_rob_mispredict = entry->pc;
+				next->bpred_hist = entry->branch_ctrl.hist;
+				if (opt_ras_flush)
+					next->ras = (ras_t){ 0 };
+				else
+					ras_restore(&next->ras, &entry->branch_ctrl.ras);
+				break;
+			}
 			if (per_pc_stats)
 				per_pc_stats[entry->pc.u].retired++;
 
 			if (entry->exception) {
 				printf("[commit] Error: Exception on retire. Either null deref or invalid instr.\n");
-				debugger_pause = 1;
+				next->stop = 1;
 				next->rob_tail = tail;
 				break;
 			}
@@ -1032,33 +1314,73 @@ int main(int argc, char **argv)
 				/* If mispredict, flush and change pc. Otherwise, do nothing. */
 				bool_t taken = (bool_t) { 0 };
 				if (b_test(entry->branch_ctrl.consider_prediction)) {
-					if (pred.u != act.u) {
+					if (pred.u != act.u && entry->branch_ctrl.recovered) {
+						tracei("[commit] Branch mispredict, recovered at execute\n");
+						taken = b_not(entry->branch_ctrl.pred_taken);
+					} else if (pred.u != act.u) {
 						tracei("[commit] Branch mispredict -- flush pipeline and jmp %x\n",
 							act.u);
 						assert(pred.u != 0xFFffFFff);
 						assert(curr->fetch_wait_rob_mispredict);
 						assert(act.u);
-						pipeline_flush(next);
 						flushed = 1;
-						size_t num = 0;
-						FOR_INDEX_ROB(curr, i) {
-							num++;
+						size_t num = ROB_COUNT(curr);
+						/* A JALR's link write sits right behind it and is
+						 * already done: retire it rather than lose it. */
+						const size_t link_i = (tail + 1) & ROB_INDEX_MASK;
+						const rob_t *link = &curr->rob[link_i];
+						if (entry->dbg_branch_info.type == ROB_BRANCH_JALR && link_i != curr->rob_head
+								&& link->type == ROB_INSTR_REGISTER && link->pc.u == entry->pc.u) {
+							assert(rob_mask_test(&curr->rob_ready, link_i));
+							prf_retire(next->prf, link->data.reg.dest.u, link->preg, link->old_preg);
+							next->stats.retired++;
+							num--;
 						}
+						pipeline_flush(curr, next);
 						next->stats.flushed += num;
 						next->pc_rob_mispredict = act;
-						next->global_branch_history = entry->branch_ctrl.global_history;
+						if (opt_ras_flush)
+							next->ras = (ras_t){ 0 };
+						else
+							ras_restore(&next->ras, &entry->branch_ctrl.ras);
 						taken = b_not(entry->branch_ctrl.pred_taken);
+						if (b_test(entry->branch_ctrl.change_bht))
+							bpred_recover(next->bpred, &next->bpred_hist, &entry->branch_ctrl.hist,
+								entry->pc, b_test(taken));
+						else
+							next->bpred_hist = entry->branch_ctrl.hist;
 					} else {
 						taken = entry->branch_ctrl.pred_taken;
 						tracei("[commit] Correct branch prediction\n");
 					}
 				}
+				if ((trace_branches || sweep) && entry->dbg_branch_info.type == ROB_BRANCH_CMP) {
+					bool bad = false;
+					const word_u instr = memory_op(mem, LSU_OP_LW, entry->pc, (word_u){ .u = 0 }, &bad);
+					next->stop |= bad;
+					const bool backward = instr_imm_btype(instr).s < 0;
+					const bool went = act.u != entry->pc.u + 4;
+					if (trace_branches) {
+						const size_t insts = next->stats.retired + 1 - trace_branches_retired;
+						const struct bpred_trace_rec rec = {
+							.pc = entry->pc.u,
+							.insts_taken = (insts << 2) | backward << 1 | went,
+						};
+						fwrite(&rec, sizeof(rec), 1, trace_branches);
+						trace_branches_retired = next->stats.retired + 1;
+					}
+					if (sweep)
+						bht_sweep_update(sweep, entry->pc, backward, went);
+				}
 				if (b_test(entry->branch_ctrl.change_bht)) {
-					bht_btac_update(curr, next, entry->pc, entry->branch_ctrl.global_history, b_test(taken), act);
+					bht_btac_update(curr, next, entry, b_test(taken), act);
 					
 				} else {
-					btac_update(&next->btac, entry->pc, act);
+					btac_update(&next->btac, entry->pc, act, true);
 				}
+				if (entry->branch_ctrl.indirect && feature_ittage && !opt_nospec)
+					ittage_update(next->ittage, &entry->branch_ctrl.hist, entry->pc,
+						act, pred.u != act.u, &next->stats);
 				break;
 			} case ROB_INSTR_REGISTER: {
 				if (entry->dbg_was_load)
@@ -1066,20 +1388,13 @@ int main(int argc, char **argv)
 				else
 					next->stats.arithmetic++;
 				word_u dest = entry->data.reg.dest;
-				word_u val = entry->data.reg.val;
-				/* Just wb to reg. */
-				tracei("[commit] %lu wb %.2X to reg %s",
-					entry->id, val.u, reg_name(dest.u));
+				/* Value is already in the register file, just make it
+				 * architectural. */
+				tracei("[commit] %lu wb %.2X to reg %s (p%u, frees p%u)\n",
+					entry->id, curr->prf->val[entry->preg].u, reg_name(dest.u),
+					entry->preg, entry->old_preg);
 				assert(dest.u && dest.u < REG_COUNT);
-				assert(curr->arf[dest.u].rob_id && next->arf[dest.u].rob_id);
-
-				next->arf[dest.u].dat = val;
-				if (next->arf[dest.u].rob_id == entry->id) {
-					tracei("(+ reset)\n");
-					next->arf[dest.u].rob_id = 0;
-				} else {
-					tracei("\n");
-				}
+				prf_retire(next->prf, dest.u, entry->preg, entry->old_preg);
 				break;
 			} case ROB_INSTR_STORE: {
 				next->stats.stores++;
@@ -1088,15 +1403,17 @@ int main(int argc, char **argv)
 				tracei("[commit] Store val %x to addr %x\n", val.u, dest.u);
 				if (dest.u == 0xFFffFFff) {
 					fprintf(stderr, "[commit] pc %x store to null ptr.\n", entry->pc.u);
-					debugger_pause = 1;
+					next->stop = 1;
 				} else if (dest.u < bin_region) {
 					tracei("[commit] note: pc %x store to code region (%x).\n", entry->pc.u, dest.u);
 				}
+				const size_t stq_id = stq_retire(&next->stq, entry->id);
+				storeset_store_retired(&next->storeset, entry->pc, stq_id);
 				bool exception = false;
 				memory_op(mem, entry->store_op, dest, val, &exception);
 				if (exception) {
 					fprintf(stderr, "[commit] exception attempting write to %x\n", dest.u);
-					debugger_pause = 1 && (!permissive);
+					next->stop = !permissive;
 				}
 				break;
 			} case ROB_INSTR_DEBUG: {
@@ -1109,13 +1426,14 @@ int main(int argc, char **argv)
 				}
 
 				cdb->rob_id = entry->id;
+				cdb->preg = entry->preg;
 
 				word_u operand = entry->data.debug.operand;
 				/* All cases except input are relatively straightforward. */
 				switch (entry->data.debug.opcode.u) {
 				case DBG_OP_BREAK:
 					printf("[dbgu] have break instr\n");
-					debugger_pause = 1;
+					next->stop = 1;
 					break;
 				case DBG_OP_QUIT:
 					printf("[dbgu] quit\n");
@@ -1123,20 +1441,28 @@ int main(int argc, char **argv)
 					break;
 				case DBG_OP_ABORT:
 					printf("[dbgu] assertion failed\n");
-					debugger_pause = 1;
+					next->stop = 1;
 					break;
 				case DBG_OP_PRINT:
 					printf("[dbgu] msg: '%s'\n", (char*)&mem[operand.u]);
 					break;
 				case DBG_OP_BENCH_BEGIN:
 					assert(!next->stats.start_clk);
-					next->stats = (struct stats){ 0 };
+					next->stats = (struct stats){ .seed = curr->stats.seed };
 					next->stats.start_clk = curr->clk;
 					printf("[dbgu] bench start at clk %lu\n", next->stats.start_clk);
 					if (trace_pc)
 						trace_pc = freopen(NULL, "wb", trace_pc);
-					next->bht = (struct bht){ 0 };
-					next->btac = (struct btac){ 0 };
+					if (trace_branches)
+						trace_branches = freopen(NULL, "wb", trace_branches);
+					trace_branches_retired = 0;
+					if (sweep)
+						bht_sweep_clear(sweep);
+					bpred_clear(next->bpred);
+					btac_clear(&next->btac);
+					ittage_clear(next->ittage);
+					loop_clear(next->loop);
+					storeset_clear(&next->storeset);
 					break;
 				case DBG_OP_BENCH_END:
 					assert(next->stats.start_clk);
@@ -1144,7 +1470,7 @@ int main(int argc, char **argv)
 					if (bench_only)
 						run = 0;
 					else
-						debugger_pause = 1;
+						next->stop = 1;
 					next->stats.start_clk = 0;
 					break;
 				case DBG_OP_INPUT:
@@ -1156,24 +1482,40 @@ int main(int argc, char **argv)
 				default:
 					assert(0 && "Programme broke debug calling convention.");
 				}
+				/* Written here too in case a flush drops the CDB. */
+				prf_write(next->prf, entry->preg, cdb->data);
+				prf_retire(next->prf, REG_T3, entry->preg, entry->old_preg);
 				break;
 			} default:
 				assert(0);
 			}
 
 			if (retired) {
-				*new_entry = (rob_t) { 0 };
-				next->stats.retired++;
+				rob_free(next, tail);
+				next->stats.retired += 1 + entry->fused;
 			} else {
-				*new_entry = *entry;
 				next->rob_tail = tail;
 			}
 		}
 	}
 
 	free(mem);
+	bpred_destroy(next->bpred);
+	bpred_hist_free(&next->bpred_hist);
+	btac_free(&next->btac);
+	free(next->ittage);
+	free(next->loop);
+	free(next->rob);
+	free(next->prf);
+	result->ok = !run && !next->stop;
 	if (curr) {
+		result->cycles = curr->clk - curr->stats.start_clk;
+		result->stats = curr->stats;
+	}
+	if (curr && !opts->quiet) {
 		stats_print(&curr->stats, curr->clk);
+		if (sweep)
+			bht_sweep_print(sweep, curr->stats.retired);
 		if (per_pc_stats) {
 			for (size_t pc = 0; pc < bin_size; pc++) {
 				const struct per_pc_stats s = per_pc_stats[pc];
@@ -1199,6 +1541,13 @@ int main(int argc, char **argv)
 				switch (s.type) {
 				case ROB_BRANCH_INVALID:
 					break;
+				case ROB_BRANCH_JALR:
+					r = (double)s.indirect_correct / (double)(s.indirect_correct + s.indirect_incorrect);
+					printf("%lu - JALR: %lx : %lu%s targets, indirect %lu\t%lu (%f)\n",
+						s.retired, pc, s.targets > PER_PC_TARGETS ? PER_PC_TARGETS : s.targets,
+						s.targets > PER_PC_TARGETS ? "+" : "",
+						s.indirect_correct, s.indirect_incorrect, r);
+					break;
 				case ROB_BRANCH_CMP:
 					r = (double)s.bht_correct / (double)(s.bht_correct + s.bht_incorrect);
 					printf("%lu - CMP BHT: %lx : %lu\t%lu (%f)\n", s.bht_correct + s.bht_incorrect, pc, s.bht_correct, s.bht_incorrect, r);
@@ -1210,7 +1559,9 @@ int main(int argc, char **argv)
 		} else {
 			printf("No granular stats (add granular to args)\n");
 		}
+	}
 
+	if (curr) {
 		free((void*)curr);
 	}
 
@@ -1218,10 +1569,285 @@ int main(int argc, char **argv)
 		free(next);
 	}
 
-	if (trace_pc) {
-		fclose(trace_pc);
+	free(per_pc_stats);
+	bht_sweep_destroy(sweep);
+	opts->trace_pc = trace_pc;
+	opts->trace_branches = trace_branches;
+}
+
+/* Multi-seed runs, shared between worker threads. */
+struct seed_pool {
+	const uint8_t *bin;
+	size_t bin_size;
+	word_u entry;
+	struct sim_opts *opts;
+
+	struct sim_run *runs;
+	size_t count;
+	size_t taken;
+};
+
+static void *seed_worker(void *arg)
+{
+	struct seed_pool *pool = arg;
+	size_t i;
+	while ((i = __atomic_fetch_add(&pool->taken, 1, __ATOMIC_RELAXED)) < pool->count) {
+		simulate(pool->bin, pool->bin_size, pool->entry, pool->opts, &pool->runs[i]);
+		printf("[seeds] seed %lu: %s, %lu cycles, %lu retired\n",
+			pool->runs[i].seed,
+			pool->runs[i].ok ? "ok" : "FAILED",
+			pool->runs[i].cycles,
+			pool->runs[i].stats.retired);
+	}
+	return NULL;
+}
+
+/* Run the same binary under seeds seed..seed+count-1, one thread per core,
+ * and report the spread of cycle counts. */
+int simulate_seeds(const uint8_t *bin, size_t bin_size, word_u entry, struct sim_opts *opts, uint64_t seed, size_t count)
+{
+	struct seed_pool pool = {
+		.bin = bin,
+		.bin_size = bin_size,
+		.entry = entry,
+		.opts = opts,
+		.runs = calloc(count, sizeof(struct sim_run)),
+		.count = count,
+	};
+	assert(pool.runs);
+	for (size_t i = 0; i < count; i++)
+		pool.runs[i].seed = seed + i;
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nthreads = cores > 0 ? (size_t)cores : 1;
+	if (nthreads > count)
+		nthreads = count;
+
+	pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+	assert(threads);
+	for (size_t i = 0; i < nthreads; i++)
+		pthread_create(&threads[i], NULL, seed_worker, &pool);
+	for (size_t i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	size_t ok = 0, min = SIZE_MAX, max = 0;
+	double sum = 0, sum_sq = 0;
+	for (size_t i = 0; i < count; i++) {
+		const struct sim_run *r = &pool.runs[i];
+		if (!r->ok)
+			continue;
+		ok++;
+		sum += (double)r->cycles;
+		sum_sq += (double)r->cycles * (double)r->cycles;
+		if (r->cycles < min)
+			min = r->cycles;
+		if (r->cycles > max)
+			max = r->cycles;
+	}
+
+	printf("\nSeeds %lu..%lu: %lu of %lu runs completed.\n", seed, seed + count - 1, ok, count);
+	if (ok) {
+		double mean = sum / (double)ok;
+		double var = ok > 1 ? (sum_sq - sum * mean) / (double)(ok - 1) : 0.;
+		double sd = var > 0 ? sqrt(var) : 0.;
+		printf("Cycles: mean %.1f, stddev %.1f (%.3f%%), min %lu, max %lu (spread %lu)\n",
+			mean, sd, 100. * sd / mean, min, max, max - min);
 	}
 
-	return 0;
+	free(pool.runs);
+	return ok == count ? 0 : -1;
 }
 
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Specify binary\n");
+		return -1;
+	}
+
+	/* Replay a branch trace through predictors, without a binary. */
+	if (strcmp(argv[1], "predict-only") == 0) {
+		if (argc < 3) {
+			fprintf(stderr, "Specify branch trace, then predictors\n");
+			return -1;
+		}
+		static const char *const def[] = { "bht" };
+		tracei_enabled = 0;
+		if (argc == 3)
+			return bpred_predict_only(argv[2], def, 1);
+		return bpred_predict_only(argv[2], (const char *const *)&argv[3], argc - 3);
+	}
+
+	/* Debugger sigint handler. */
+	{
+		struct sigaction sigint;
+		sigint.sa_handler = handle_sigint;
+		sigemptyset(&sigint.sa_mask);
+		sigint.sa_flags = 0;
+
+		sigaction(SIGINT, &sigint, NULL);
+	}
+
+	static_assert(sizeof(uint8_t) == 1, "Need 8 bit chars.");
+
+	uint8_t *bin = NULL;
+	word_u entry;
+	const size_t bin_size = binary_load(argv[1], &bin, &entry);
+	if (!bin_size) {
+		free(bin);
+		return -1;
+	}
+
+	struct sim_opts opts = { 0 };
+	uint64_t seed = 0;
+	size_t seeds = 0;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "bench") == 0) {
+			opts.bench_only = 1;
+			tracei_enabled = 0;
+			debugger_pause = 0;
+		} else if (strcmp(argv[i], "loud") == 0) {
+			tracei_enabled = 1;
+		} else if (strcmp(argv[i], "granular") == 0) {
+			opts.granular_stats = 1;
+		} else if (strcmp(argv[i], "trace") == 0) {
+			if (!opts.trace_pc)
+				opts.trace_pc = fopen("pc_trace", "wb");
+			if (!opts.trace_pc)
+				fprintf(stderr, "Failed to open trace file");
+		} else if (strcmp(argv[i], "seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 0);
+		} else if (strcmp(argv[i], "seeds") == 0 && i + 1 < argc) {
+			seeds = strtoull(argv[++i], NULL, 0);
+		} else if (strcmp(argv[i], "static") == 0) {
+			feature_branch_bht_btac = false;
+		} else if (strcmp(argv[i], "no2level") == 0) {
+			feature_2level = false;
+		} else if (strcmp(argv[i], "noforward") == 0) {
+			feature_store_forward = false;
+		} else if (strcmp(argv[i], "clearhistoryoncall") == 0) {
+			opt_clearhistoncall = true;
+		} else if (strcmp(argv[i], "1bitbht") == 0) {
+			opt_1bitbht = true;
+		} else if (strcmp(argv[i], "nospec") == 0) {
+			opt_nospec = true;
+		} else if (strcmp(argv[i], "branchtrace") == 0) {
+			if (!opts.trace_branches)
+				opts.trace_branches = fopen("branch_trace", "wb");
+			if (!opts.trace_branches)
+				fprintf(stderr, "Failed to open branch trace file");
+		} else if (strcmp(argv[i], "bhtsweep") == 0) {
+			opts.bht_sweep = true;
+		} else if (strcmp(argv[i], "bpred") == 0 && i + 1 < argc) {
+			opts.bpred = argv[++i];
+		} else if (strcmp(argv[i], "tage") == 0) {
+			opts.bpred = "tage";
+		} else if (strcmp(argv[i], "perceptron") == 0) {
+			opts.bpred = "perceptron";
+		} else if (strcmp(argv[i], "gshare") == 0) {
+			opt_gshare = true;
+		} else if (strcmp(argv[i], "nostoreset") == 0) {
+			feature_storeset = false;
+		} else if (strcmp(argv[i], "noloop") == 0) {
+			feature_loop = false;
+		} else if (strcmp(argv[i], "noittage") == 0) {
+			feature_ittage = false;
+		} else if (strcmp(argv[i], "noearlyrecover") == 0) {
+			feature_early_recovery = false;
+		} else if (strcmp(argv[i], "nomoveelim") == 0) {
+			feature_move_elim = false;
+		} else if (strcmp(argv[i], "inorderloads") == 0) {
+			feature_ooo_loads = false;
+		} else if (strcmp(argv[i], "rasflush") == 0) {
+			opt_ras_flush = true;
+		} else if (strcmp(argv[i], "btacrrip") == 0) {
+			opt_btac_rrip = true;
+		} else if (strcmp(argv[i], "nostorechk") == 0) {
+			opt_nostorechk = true;
+		} else if (strcmp(argv[i], "nofuse") == 0) {
+			/* Optionally just the one idiom. */
+			const enum fuse_idiom f = i + 1 < argc ? fuse_parse(argv[i + 1]) : FUSE_COUNT;
+			if (f != FUSE_COUNT) {
+				fuse_enabled[f] = false;
+				i++;
+			} else {
+				for (size_t j = 0; j < FUSE_COUNT; j++)
+					fuse_enabled[j] = false;
+			}
+		} else if (strcmp(argv[i], "issue") == 0 && i + 1 < argc) {
+			const char *p = argv[++i];
+			if (strcmp(p, "oldest") == 0) {
+				opt_issue = ISSUE_OLDEST;
+			} else if (strcmp(p, "branchfirst") == 0) {
+				opt_issue = ISSUE_BRANCH_FIRST;
+			} else if (strcmp(p, "loadfirst") == 0) {
+				opt_issue = ISSUE_LOAD_FIRST;
+			} else {
+				fprintf(stderr, "Unknown issue policy %s, have: oldest branchfirst loadfirst\n", p);
+				return -1;
+			}
+		} else if (strcmp(argv[i], "latency") == 0 && i + 2 < argc) {
+			const enum fu_class c = fu_class_parse(argv[i + 1]);
+			/* The divider takes nothing new until it's done, so it has no
+			 * interval. */
+			const bool has_ii = c != FU_DIV;
+			const long lat = atol(argv[i + 2]),
+			      ii = has_ii && i + 3 < argc ? atol(argv[i + 3]) : 0;
+			if (c == FU_CLASS_COUNT || lat < 1 || (has_ii && ii < 1)) {
+				fprintf(stderr, "Usage: latency <class> <cycles> <interval>, or latency div <cycles>, classes:");
+				for (size_t k = 0; k < FU_CLASS_COUNT; k++)
+					fprintf(stderr, " %s", fu_class_str(k));
+				fprintf(stderr, "\n");
+				return -1;
+			}
+			fu_timing[c] = (struct fu_timing) { lat, ii };
+			i += 2 + has_ii;
+		} else if (strcmp(argv[i], "fetchtaken") == 0 && i + 1 < argc) {
+			opt_fetch_taken = strtoul(argv[++i], NULL, 0);
+		} else if (strcmp(argv[i], "permissive") == 0) {
+			opts.permissive = true;
+		} else {
+			fprintf(stderr, "Unknown option: %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	if (opts.bpred) {
+		struct bpred *bp = bpred_create(opts.bpred);
+		if (!bp) {
+			fprintf(stderr, "Unknown predictor %s, have: ", opts.bpred);
+			bpred_list(stderr);
+			return -1;
+		}
+		bpred_destroy(bp);
+	}
+
+	int ret = 0;
+	if (seeds) {
+		if (opts.trace_pc || opts.trace_branches || opts.granular_stats || opts.bht_sweep) {
+			fprintf(stderr, "trace, granular and bhtsweep can't be used with seeds.\n");
+			return -1;
+		}
+		/* Nobody to talk to the debugger. */
+		opts.bench_only = 1;
+		opts.quiet = 1;
+		tracei_enabled = 0;
+		debugger_pause = 0;
+		ret = simulate_seeds(bin, bin_size, entry, &opts, seed, seeds);
+	} else {
+		struct sim_run run = { .seed = seed };
+		simulate(bin, bin_size, entry, &opts, &run);
+	}
+
+	free(bin);
+
+	if (opts.trace_pc) {
+		fclose(opts.trace_pc);
+	}
+	if (opts.trace_branches) {
+		fclose(opts.trace_branches);
+	}
+
+	return ret;
+}
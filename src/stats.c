@@ -4,6 +4,12 @@
 
 #include <stdio.h>
 
+/* 0 rather than nan when nothing happened. */
+static double frac(size_t n, size_t of)
+{
+	return of ? (double)n / (double)of : 0.;
+}
+
 void stats_print(const struct stats *stats, size_t clk)
 {
 	{
@@ -34,6 +40,7 @@ void stats_print(const struct stats *stats, size_t clk)
 			wldf = (double)wld / (double)i;
 
 		printf("Benchmark retired %lu and flushed %lu in %lu clocks\n", r, f, c);
+		printf("Seed: %lu\n", stats->seed);
 		printf("Issued %lu\n", i);
 		printf("Waited: %lu (%f) for args, %lu (%f) for exec unit, %lu (%f) for cdb, %lu (%f) on store addr, %lu (%f) on store data.\n",
 				wa, waf,
@@ -41,9 +48,33 @@ void stats_print(const struct stats *stats, size_t clk)
 				wc, wcf,
 				wla, wlaf,
 				wld, wldf);
+		printf("Store forwarding: %lu (%f of loads) loads took all bytes from stores, %lu (%f) some.\n",
+				stats->forward_full, frac(stats->forward_full, il),
+				stats->forward_partial, frac(stats->forward_partial, il));
+		printf("Store sets: %lu (%f of loads) loads went past unresolved stores, %lu (%f of those) violations.\n",
+				stats->storeset_bypass, frac(stats->storeset_bypass, il),
+				stats->storeset_violation, frac(stats->storeset_violation, stats->storeset_bypass));
+		printf("Load buffer: %lu (%f of loads) issued before an older load, %lu load-load order violations.\n",
+				stats->ldb_ooo_issue, frac(stats->ldb_ooo_issue, il),
+				stats->load_order_violation);
+		printf("Issue policy put %lu ops ahead of older ready ones.\n", stats->issue_promoted);
 		printf("Spent %lu (%f) cycles stalled from mispredict.\n", st, (double)st / (double)c);
+		printf("Recovered %lu mispredicts at execute, squashing %lu (%f each) ROB entries.\n",
+				stats->early_recover, stats->early_squashed,
+				frac(stats->early_squashed, stats->early_recover));
+		printf("Decode held %lu times with no free physical register.\n", stats->stall_prf);
+		printf("Done at rename: %lu moves, %lu zero idioms, %lu constants.\n",
+				stats->elim_move, stats->elim_zero, stats->elim_const);
 		printf("IPC: %f (%f excluding mispredict penalty)\n", ipc, ipc_b);
 		printf("Avg decode window: %f\n", fw_sz);
+		printf("Fetch buffer: %f avg instrs, full for %lu cycles, decode starved %lu (%f) cycles. FTQ: %f avg blocks.\n",
+				(double)stats->fetch_buf_sum / (double)c, stats->fetch_buf_full,
+				stats->decode_starved, (double)stats->decode_starved / (double)c,
+				(double)stats->ftq_sum / (double)c);
+		printf("Fused:");
+		for (size_t j = FUSE_NONE + 1; j < FUSE_COUNT; j++)
+			printf(" %lu %s", stats->fused[j], fuse_idiom_str(j));
+		printf(".\n");
 		printf("Max recursion: %lu\n", stats->recursion_depth_max);
 		const char *fmt = "%s:\t%lu\t(%f%%)\n";
 		printf(fmt, "Loads", il, (double)il*100. / (double)r);
@@ -76,16 +107,24 @@ void stats_print(const struct stats *stats, size_t clk)
 			ri = stats->jalr_ras_incorrect,
 			a = ac + ai,
 			r = rc + ri,
+			ic = stats->jalr_ind_correct,
+			ii = stats->jalr_ind_incorrect,
+			i = ic + ii,
 			m = stats->jalr_btac_miss,
-			t = a + m + r;
+			t = a + m + r + i;
 		double	ar = 100. * (double)a / (double)t,
 			rr = 100. * (double)r / (double)t,
+			ir = 100. * (double)i / (double)t,
+			icr = 100. * (double)ic / (double)i,
 			mr = 100. * (double)m / (double)t,
 			acr = 100. * (double)ac / (double)a,
 			rcr = 100. * (double)rc / (double)r;
 		printf(stat_fmt, "BTAC", a, ar, ac, ai, acr);
 		printf(stat_fmt, "RAS ", r, rr, rc, ri, rcr);
+		printf(stat_fmt, "Ind ", i, ir, ic, ii, icr);
 		printf(stat_fmt, "None", m, mr, 0, 0, 0.);
+		printf("RAS: %lu overflows, %lu underflows.\n",
+			stats->ras_overflow, stats->ras_underflow);
 	}
 	printf("Conditional:\n");
 	{
@@ -121,6 +160,47 @@ void stats_print(const struct stats *stats, size_t clk)
 
 		printf("BHT conflicts: %lu / %lu (%f%%)\n", c, t, cr);
 	}
+	if (stats->loop_correct + stats->loop_incorrect) {
+		size_t lc = stats->loop_correct,
+		       l = lc + stats->loop_incorrect,
+		       o = stats->loop_override;
+		printf("Loop predictor: %lu hits, %lu correct (%.2f%%); overrode %lu, %lu correct (%.2f%%).\n",
+			l, lc, 100. * (double)lc / (double)l,
+			o, stats->loop_override_correct, 100. * (double)stats->loop_override_correct / (double)o);
+	}
+	printf("BTAC misses: %lu cold, %lu capacity, %lu conflict; %lu aliased hits.\n",
+		stats->btac_miss_cold, stats->btac_miss_capacity,
+		stats->btac_miss_conflict, stats->btac_alias);
+	if (stats->ittage_alloc + stats->ittage_alloc_fail)
+		printf("ITTAGE: %lu allocations, %lu failed.\n",
+			stats->ittage_alloc, stats->ittage_alloc_fail);
+	if (stats->tage_correct + stats->tage_incorrect) {
+		size_t tc = stats->tage_correct,
+		       t = tc + stats->tage_incorrect;
+		printf("TAGE: %lu / %lu correct (%.2f%%), %lu allocations, %lu failed.\n",
+			tc, t, 100. * (double)tc / (double)t,
+			stats->tage_alloc, stats->tage_alloc_fail);
+		printf("TAGE provider: base %lu", stats->tage_provider[0]);
+		for (size_t i = 1; i <= TAGE_TABLES; i++)
+			printf(", T%lu %lu", i, stats->tage_provider[i]);
+		printf("\n");
+	}
+	if (stats->perceptron_correct + stats->perceptron_incorrect) {
+		size_t pc = stats->perceptron_correct,
+		       t = pc + stats->perceptron_incorrect;
+		printf("Perceptron: %lu / %lu correct (%.2f%%), trained on %lu.\n",
+			pc, t, 100. * (double)pc / (double)t, stats->perceptron_trained);
+	}
+	if (stats->tourn_correct + stats->tourn_incorrect) {
+		size_t tc = stats->tourn_correct,
+		       t = tc + stats->tourn_incorrect;
+		printf("Tournament: %lu / %lu correct (%.2f%%); chose local %lu, global %lu.\n",
+			tc, t, 100. * (double)tc / (double)t,
+			stats->tourn_chose_local, stats->tourn_chose_global);
+		printf("Tournament components right: local %lu (%.2f%%), global %lu (%.2f%%).\n",
+			stats->tourn_local_correct, 100. * (double)stats->tourn_local_correct / (double)t,
+			stats->tourn_global_correct, 100. * (double)stats->tourn_global_correct / (double)t);
+	}
 }
 
 
@@ -1,13 +1,26 @@
 #pragma once
 #include <stddef.h>
 
+#include "config.h"
+#include "fuse.h"
+
 struct stats {
-	size_t start_clk,
+	size_t seed,
+		start_clk,
 		issued,
 		retired,
 		flushed,
 		stalled,
 		stall_mispredict,
+		/* Mispredicts recovered at the BRU, and ROB entries they squashed. */
+		early_recover,
+		early_squashed,
+		/* Decode held with the free list empty. */
+		stall_prf,
+		/* Done at rename: moves aliased, zeroing and constant idioms. */
+		elim_move,
+		elim_zero,
+		elim_const,
 
 		wait_args,
 		wait_ex,
@@ -15,11 +28,32 @@ struct stats {
 		wait_store_addr,
 		wait_store_data,
 
+		forward_full,
+		forward_partial,
+
+		storeset_bypass,
+		storeset_violation,
+
+		ldb_ooo_issue,
+		/* Picked by the issue policy over an older ready op. */
+		issue_promoted,
+		load_order_violation,
+
 		recursion_depth,
 		recursion_depth_max,
 
 		fetch_window_cnt,
 		fetch_window_sum,
+		/* Summed every cycle, for the average. */
+		fetch_buf_sum,
+		ftq_sum,
+		/* Fetch had a block but no room, decode had nothing
+		 * (redirects included). */
+		fetch_buf_full,
+		decode_starved,
+
+		/* Pairs decode fused, by enum fuse_idiom. */
+		fused[FUSE_COUNT],
 
 		branches,
 		loads,
@@ -37,13 +71,49 @@ struct stats {
 		jalr_btac_correct,
 		jalr_btac_incorrect,
 		jalr_btac_miss,
+		ras_overflow,
+		ras_underflow,
+		jalr_ind_correct,
+		jalr_ind_incorrect,
+		ittage_alloc,
+		ittage_alloc_fail,
 
 		cmp_bht_correct,
 		cmp_bht_incorrect,
 		cmp_btac_correct,
 		cmp_btac_incorrect,
 		cmp_static_correct,
-		cmp_static_incorrect;
+		cmp_static_incorrect,
+
+		btac_miss_cold,
+		btac_miss_capacity,
+		btac_miss_conflict,
+		/* Partial tag hits for the wrong instruction. */
+		btac_alias,
+
+		loop_correct,
+		loop_incorrect,
+		loop_override,
+		loop_override_correct,
+
+		tage_correct,
+		tage_incorrect,
+		tage_alloc,
+		tage_alloc_fail,
+
+		perceptron_correct,
+		perceptron_incorrect,
+		perceptron_trained,
+
+		tourn_correct,
+		tourn_incorrect,
+		tourn_chose_local,
+		tourn_chose_global,
+		/* Whether each component was right, chosen or not. */
+		tourn_local_correct,
+		tourn_global_correct;
+	/* Base table, then each tagged table. */
+	size_t tage_provider[TAGE_TABLES + 1];
 };
 
 void stats_print(const struct stats *stats, size_t clk);
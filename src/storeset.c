@@ -0,0 +1,65 @@
+#include "storeset.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "util.h"
+
+static inline size_t ssit_index(word_u pc)
+{
+	return (pc.u / 4) & SSIT_INDEX_MASK;
+}
+
+size_t storeset_load_dep(const struct storeset *ss, word_u pc)
+{
+	const uint8_t set = ss->ssit[ssit_index(pc)];
+	if (set && ss->lfst[set - 1])
+		return ss->lfst[set - 1] - 1;
+	else
+		return STQ_SIZE;
+}
+
+void storeset_store_fetched(struct storeset *next, word_u pc, size_t stq_id)
+{
+	const uint8_t set = next->ssit[ssit_index(pc)];
+	if (set)
+		next->lfst[set - 1] = stq_id + 1;
+}
+
+void storeset_store_retired(struct storeset *next, word_u pc, size_t stq_id)
+{
+	const uint8_t set = next->ssit[ssit_index(pc)];
+	if (set && next->lfst[set - 1] == stq_id + 1)
+		next->lfst[set - 1] = 0;
+}
+
+void storeset_violation(struct storeset *next, word_u load_pc, word_u store_pc)
+{
+	uint8_t *load = &next->ssit[ssit_index(load_pc)];
+	uint8_t *store = &next->ssit[ssit_index(store_pc)];
+
+	/* New set named after the load, otherwise join the existing one
+	 * (the lower numbered, if both have one). */
+	if (!*load && !*store) {
+		*load = *store = ((load_pc.u / 4) & LFST_INDEX_MASK) + 1;
+	} else if (!*load) {
+		*load = *store;
+	} else if (!*store) {
+		*store = *load;
+	} else if (*load < *store) {
+		*store = *load;
+	} else {
+		*load = *store;
+	}
+	tracei("[storeset] load %x and store %x now in set %d\n", load_pc.u, store_pc.u, *load - 1);
+}
+
+void storeset_flush(struct storeset *next)
+{
+	memset(next->lfst, 0, sizeof(next->lfst));
+}
+
+void storeset_clear(struct storeset *next)
+{
+	*next = (struct storeset) { 0 };
+}
@@ -0,0 +1,34 @@
+/* Store set memory dependence predictor.
+ * Loads and stores which have conflicted are put in the same store set.
+ * A load then waits only for the last fetched store of its set, and is
+ * free to go past any other store whose address isn't known yet. */
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+#include "word.h"
+
+struct storeset {
+	/* Store Set ID Table: set + 1 by pc, or 0. */
+	uint8_t ssit[SSIT_SIZE];
+	/* Last Fetched Store Table: store queue entry + 1 by set, or 0. */
+	uint8_t lfst[LFST_SIZE];
+};
+
+/* Store queue entry a load should wait for, or STQ_SIZE if none. */
+size_t storeset_load_dep(const struct storeset *ss, word_u pc);
+
+/* A store has been given a store queue entry. */
+void storeset_store_fetched(struct storeset *next, word_u pc, size_t stq_id);
+
+/* A store has left the store queue. */
+void storeset_store_retired(struct storeset *next, word_u pc, size_t stq_id);
+
+/* A load went past a store it overlapped with, put them in the same set. */
+void storeset_violation(struct storeset *next, word_u load_pc, word_u store_pc);
+
+/* Forget stores in flight. */
+void storeset_flush(struct storeset *next);
+
+/* Forget everything, so sets don't grow without bound. */
+void storeset_clear(struct storeset *next);
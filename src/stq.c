@@ -0,0 +1,201 @@
+#include "stq.h"
+
+#include <assert.h>
+
+#include "util.h"
+
+#define STQ_ALL (STQ_SIZE == 64 ? ~(stq_mask_t)0 : STQ_BIT(STQ_SIZE) - 1)
+
+/* Entries below i. */
+static inline stq_mask_t stq_below(size_t i)
+{
+	return i ? ~(stq_mask_t)0 >> (64 - i) : 0;
+}
+
+static inline size_t stq_bucket(uint64_t word)
+{
+	return (word ^ (word >> 6)) & STQ_HASH_MASK;
+}
+
+/* Entries from tail up to (not including) pos. */
+static stq_mask_t stq_older(size_t tail, size_t pos)
+{
+	const stq_mask_t from_tail = STQ_ALL & ~stq_below(tail);
+	if (tail <= pos)
+		return from_tail & stq_below(pos);
+	else
+		return from_tail | stq_below(pos);
+}
+
+/* Youngest of some entries older than pos. */
+static size_t stq_youngest(stq_mask_t m, size_t pos)
+{
+	assert(m);
+	const stq_mask_t lo = m & stq_below(pos);
+	if (lo)
+		return 63 - __builtin_clzll(lo);
+	else
+		return 63 - __builtin_clzll(m);
+}
+
+static void stq_index(struct stq *stq, size_t id, bool set)
+{
+	const stq_entry_t *e = &stq->buffer[id];
+	const uint64_t first = e->addr.u >> 2;
+	const uint64_t last = ((uint64_t)e->addr.u + lsu_op_bytes(e->op) - 1) >> 2;
+	for (uint64_t w = first; w <= last; w++) {
+		if (set)
+			stq->words[stq_bucket(w)] |= STQ_BIT(id);
+		else
+			stq->words[stq_bucket(w)] &= ~STQ_BIT(id);
+	}
+}
+
+size_t lsu_op_bytes(enum lsu_op op)
+{
+	return 1u << (op & LSU_WIDTH_MASK);
+}
+
+bool addrs_overlap(word_u a, size_t a_bytes, word_u b, size_t b_bytes)
+{
+	return (uint64_t)a.u < (uint64_t)b.u + b_bytes
+		&& (uint64_t)b.u < (uint64_t)a.u + a_bytes;
+}
+
+stq_entry_t *stq_find_free(const struct stq *curr, struct stq *next)
+{
+	const size_t ni = (next->head + 1) & STQ_INDEX_MASK;
+	if (ni == curr->tail)
+		return NULL;
+	else
+		return &next->buffer[next->head];
+}
+
+size_t stq_alloc(const struct stq *curr, struct stq *next, size_t rob_id, word_u pc, enum lsu_op op)
+{
+	const size_t ni = (next->head + 1) & STQ_INDEX_MASK;
+	assert(ni != curr->tail);
+
+	const size_t id = next->head;
+	assert(!next->buffer[id].busy);
+	next->buffer[id] = (stq_entry_t) {
+		.rob_id = rob_id,
+		.pc = pc,
+		.op = op,
+		.busy = 1,
+	};
+	next->unknown |= STQ_BIT(id);
+	next->head = ni;
+	return id;
+}
+
+void stq_set_addr(struct stq *next, size_t id, word_u addr)
+{
+	stq_entry_t *e = &next->buffer[id];
+	assert(e->busy);
+	assert(!e->addr.u && addr.u);
+	e->addr = addr;
+	next->unknown &= ~STQ_BIT(id);
+	next->resolved |= STQ_BIT(id);
+	stq_index(next, id, 1);
+}
+
+void stq_set_val(struct stq *next, size_t id, word_u val)
+{
+	stq_entry_t *e = &next->buffer[id];
+	assert(e->busy);
+	assert(!e->val_ready);
+	e->val = val;
+	e->val_ready = 1;
+}
+
+size_t stq_retire(struct stq *next, size_t rob_id)
+{
+	const size_t id = next->tail;
+	stq_entry_t *e = &next->buffer[id];
+	assert(e->busy && e->rob_id == rob_id);
+	assert(e->addr.u);
+	stq_index(next, id, 0);
+	*e = (stq_entry_t) { 0 };
+	next->tail = (id + 1) & STQ_INDEX_MASK;
+	return id;
+}
+
+void stq_squash(struct stq *next, size_t pos)
+{
+	for (size_t id = pos; id != next->head; id = (id + 1) & STQ_INDEX_MASK) {
+		stq_entry_t *e = &next->buffer[id];
+		assert(e->busy);
+		if (e->addr.u)
+			stq_index(next, id, 0);
+		next->unknown &= ~STQ_BIT(id);
+		next->resolved &= ~STQ_BIT(id);
+		*e = (stq_entry_t) { 0 };
+	}
+	next->head = pos;
+}
+
+void stq_forward(const struct stq *stq, size_t stq_pos, enum lsu_op op, word_u addr,
+	stq_mask_t wait_unknown, struct stq_fwd *fwd)
+{
+	assert(addr.u);
+	const size_t bytes = lsu_op_bytes(op);
+	const stq_mask_t older = stq_older(stq->tail, stq_pos);
+	const stq_mask_t skipped = stq->unknown & ~wait_unknown & older;
+	*fwd = (struct stq_fwd) { .bypassed = skipped != 0 };
+	/* Bytes of the load no store has given us yet. */
+	uint8_t need = (1u << bytes) - 1;
+
+	stq_mask_t cand = stq->unknown & wait_unknown;
+	const uint64_t first = addr.u >> 2;
+	const uint64_t last = ((uint64_t)addr.u + bytes - 1) >> 2;
+	for (uint64_t w = first; w <= last; w++)
+		cand |= stq->words[stq_bucket(w)];
+	cand &= older;
+
+	/* Youngest first, skipping hash collisions. */
+	while (cand) {
+		const size_t id = stq_youngest(cand, stq_pos);
+		cand &= ~STQ_BIT(id);
+
+		const stq_entry_t *e = &stq->buffer[id];
+		assert(e->busy);
+		if (!e->addr.u) {
+			fwd->wait = 1;
+			return;
+		}
+		const size_t e_bytes = lsu_op_bytes(e->op);
+		if (!addrs_overlap(addr, bytes, e->addr, e_bytes))
+			continue;
+
+		for (size_t i = 0; i < bytes; i++) {
+			const uint64_t at = (uint64_t)addr.u + i;
+			if (!(need & (1u << i)) || at < e->addr.u || at >= (uint64_t)e->addr.u + e_bytes)
+				continue;
+			if (!e->val_ready) {
+				fwd->wait = 1;
+				fwd->wait_val = 1;
+				return;
+			}
+			const uint8_t byte = e->val.u >> (8 * (at - e->addr.u));
+			fwd->val.u |= (uint32_t)byte << (8 * i);
+			fwd->mask |= 1u << i;
+			need &= ~(1u << i);
+		}
+		if (!need) {
+			/* Only stores younger than this one could have changed the bytes. */
+			fwd->bypassed = (skipped & stq_older((id + 1) & STQ_INDEX_MASK, stq_pos)) != 0;
+			return;
+		}
+	}
+}
+
+word_u stq_fwd_merge(const struct stq_fwd *fwd, word_u mem)
+{
+	uint32_t bits = 0;
+	for (size_t i = 0; i < 4; i++) {
+		if (fwd->mask & (1u << i))
+			bits |= 0xffu << (8 * i);
+	}
+	return (word_u){ .u = (mem.u & ~bits) | fwd->val.u };
+}
@@ -0,0 +1,90 @@
+/* Store Queue.
+ * Holds stores in age order from decode until retire, indexed by the words
+ * they touch, so a load can find the youngest older overlapping store
+ * without walking the ROB. */
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+#include "lsu.h"
+#include "word.h"
+
+/* One bit per store queue entry. */
+typedef uint64_t stq_mask_t;
+
+#define STQ_BIT(i) ((stq_mask_t)1 << (i))
+
+typedef struct {
+	size_t rob_id;
+	word_u pc;
+	enum lsu_op op;
+
+	/* 0 until the base register is known. */
+	word_u addr;
+	word_u val;
+	bool val_ready;
+
+	bool busy;
+} stq_entry_t;
+
+struct stq {
+	stq_entry_t buffer[STQ_SIZE];
+	/* Same convention as the ROB:
+	 * Head - index of next insertion,
+	 * Tail - oldest store. */
+	size_t head;
+	size_t tail;
+
+	/* Entries with a byte in a word hashing to this bucket. */
+	stq_mask_t words[STQ_HASH_SIZE];
+	/* Entries without an address yet. */
+	stq_mask_t unknown;
+	/* Entries whose address arrived this cycle. */
+	stq_mask_t resolved;
+};
+
+/* Number of bytes accessed by a load or store. */
+size_t lsu_op_bytes(enum lsu_op op);
+
+/* True if [a, a + a_bytes) and [b, b + b_bytes) share a byte. */
+bool addrs_overlap(word_u a, size_t a_bytes, word_u b, size_t b_bytes);
+
+/* Next entry to allocate, or NULL if we're full. */
+stq_entry_t *stq_find_free(const struct stq *curr, struct stq *next);
+
+/* Allocate an entry for a store, returning its index. */
+size_t stq_alloc(const struct stq *curr, struct stq *next, size_t rob_id, word_u pc, enum lsu_op op);
+
+/* Base register known. */
+void stq_set_addr(struct stq *next, size_t id, word_u addr);
+
+/* Data register known. */
+void stq_set_val(struct stq *next, size_t id, word_u val);
+
+/* Free the oldest entry, which must belong to this ROB entry.
+ * Returns its index. */
+size_t stq_retire(struct stq *next, size_t rob_id);
+
+/* Free every entry from pos up to the head, which moves back to pos. */
+void stq_squash(struct stq *next, size_t pos);
+
+/* Bytes a load gets from older stores. */
+struct stq_fwd {
+	/* Byte i of the load is byte i of val if bit i of mask is set. */
+	word_u val;
+	uint8_t mask;
+	/* Some byte's youngest older store has no address or no data yet. */
+	bool wait;
+	bool wait_val;
+	/* A store with unknown address that could matter was ignored. */
+	bool bypassed;
+};
+
+/* For a load with address addr, issued when the store queue head was at
+ * stq_pos, take each byte from the youngest older store writing it.
+ * Stores with unknown addresses count only if in wait_unknown. */
+void stq_forward(const struct stq *stq, size_t stq_pos, enum lsu_op op, word_u addr,
+	stq_mask_t wait_unknown, struct stq_fwd *fwd);
+
+/* Put the forwarded bytes over what was read from memory. */
+word_u stq_fwd_merge(const struct stq_fwd *fwd, word_u mem);
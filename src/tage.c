@@ -0,0 +1,224 @@
+#include "tage.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "stats.h"
+#include "util.h"
+
+/* Geometric history lengths, MIN * (MAX / MIN)^(i / (TAGE_TABLES - 1))
+ * rounded, and tag widths growing with them. */
+static const size_t hist_len[TAGE_TABLES] = {
+	TAGE_MIN_HIST, 9, 15, 27, 46, 81, TAGE_MAX_HIST
+};
+static const size_t tag_bits[TAGE_TABLES] = { 9, 9, 10, 10, 11, 11, 12 };
+
+_Static_assert(BPRED_HIST_LEN > TAGE_MAX_HIST, "history buffer shorter than longest table");
+_Static_assert(BPRED_FOLDS >= 3 * TAGE_TABLES, "not enough folded histories");
+
+/* Folded histories: index, then two for the tag, per table. */
+#define FOLD_IDX(i) ((i) * 3)
+#define FOLD_TAG(i, j) ((i) * 3 + 1 + (j))
+
+enum {
+	CTR_MAX = 3,
+	CTR_MIN = -4,
+	U_MAX = 3,
+	USE_ALT_MAX = 7,
+	USE_ALT_MIN = -8,
+	/* Updates between halving the useful bits. */
+	U_RESET_PERIOD = 1 << 18,
+};
+
+struct lookup {
+	size_t idx[TAGE_TABLES];
+	uint16_t tag[TAGE_TABLES];
+	size_t base;
+	/* TAGE_TABLES when there is no hit. */
+	size_t provider;
+	size_t alt;
+	bool provider_pred;
+	bool alt_pred;
+	bool pred;
+};
+
+static void tage_clear(void *self)
+{
+	struct tage *tage = self;
+	memset(tage, 0, sizeof(*tage));
+	/* Weakly taken. */
+	memset(tage->base, 2, sizeof(tage->base));
+	tage->alloc_seed = 1;
+}
+
+static bool ctr_taken(int8_t ctr)
+{
+	return ctr >= 0;
+}
+
+static bool ctr_weak(int8_t ctr)
+{
+	return ctr == 0 || ctr == -1;
+}
+
+static int8_t ctr_update(int8_t ctr, bool taken, int8_t min, int8_t max)
+{
+	if (taken)
+		return ctr < max ? ctr + 1 : ctr;
+	else
+		return ctr > min ? ctr - 1 : ctr;
+}
+
+static void lookup(const struct tage *tage, const struct bpred_hist *hist, word_u pc, struct lookup *l)
+{
+	const uint32_t p = pc.u >> 2;
+	l->base = p & (TAGE_BASE_SIZE - 1);
+	l->provider = l->alt = TAGE_TABLES;
+	for (size_t i = 0; i < TAGE_TABLES; i++) {
+		l->idx[i] = (p ^ (p >> (TAGE_INDEX_BITS - i)) ^ hist->fold[FOLD_IDX(i)]) & (TAGE_TABLE_SIZE - 1);
+		l->tag[i] = (p ^ hist->fold[FOLD_TAG(i, 0)] ^ (hist->fold[FOLD_TAG(i, 1)] << 1))
+			& ((1u << tag_bits[i]) - 1);
+	}
+	for (size_t i = TAGE_TABLES; i-- > 0;) {
+		if (tage->table[i][l->idx[i]].tag != l->tag[i])
+			continue;
+		if (l->provider == TAGE_TABLES) {
+			l->provider = i;
+		} else {
+			l->alt = i;
+			break;
+		}
+	}
+
+	l->alt_pred = l->alt == TAGE_TABLES ? tage->base[l->base] > 1
+		: ctr_taken(tage->table[l->alt][l->idx[l->alt]].ctr);
+	if (l->provider == TAGE_TABLES) {
+		l->provider_pred = l->pred = l->alt_pred;
+		return;
+	}
+	const struct tage_entry *e = &tage->table[l->provider][l->idx[l->provider]];
+	l->provider_pred = ctr_taken(e->ctr);
+	/* A fresh entry is often worse than the alternate. */
+	if (ctr_weak(e->ctr) && e->u == 0 && tage->use_alt >= 0)
+		l->pred = l->alt_pred;
+	else
+		l->pred = l->provider_pred;
+}
+
+static enum bpred_dir tage_predict(const void *self, const struct bpred_hist *hist, word_u pc)
+{
+	struct lookup l;
+	lookup(self, hist, pc, &l);
+	return l.pred ? BPRED_TAKEN : BPRED_NOT_TAKEN;
+}
+
+static void tage_spec_update(struct bpred_hist *hist, word_u pc, bool taken)
+{
+	bpred_hist_shift(hist, pc, taken);
+	for (size_t i = 0; i < TAGE_TABLES; i++) {
+		const bool out = bpred_hist_bit(hist, hist_len[i]);
+		uint16_t *f = &hist->fold[FOLD_IDX(i)];
+		f[0] = bpred_fold(f[0], TAGE_INDEX_BITS, hist_len[i], taken, out);
+		f[1] = bpred_fold(f[1], tag_bits[i], hist_len[i], taken, out);
+		f[2] = bpred_fold(f[2], tag_bits[i] - 1, hist_len[i], taken, out);
+	}
+}
+
+static void allocate(struct tage *tage, const struct lookup *l, bool taken, struct stats *stats)
+{
+	const size_t first = l->provider == TAGE_TABLES ? 0 : l->provider + 1;
+	if (first >= TAGE_TABLES)
+		return;
+	/* Sometimes skip the first free table so that not every branch piles
+	 * into the shortest histories. */
+	tage->alloc_seed = tage->alloc_seed * 1103515245u + 12345u;
+	bool skip = (tage->alloc_seed >> 16) & 1;
+	for (size_t i = first; i < TAGE_TABLES; i++) {
+		struct tage_entry *e = &tage->table[i][l->idx[i]];
+		if (e->u)
+			continue;
+		if (skip && i + 1 < TAGE_TABLES && !tage->table[i + 1][l->idx[i + 1]].u) {
+			skip = 0;
+			continue;
+		}
+		*e = (struct tage_entry) {
+			.ctr = taken ? 0 : -1,
+			.tag = l->tag[i],
+		};
+		stats->tage_alloc++;
+		return;
+	}
+	for (size_t i = first; i < TAGE_TABLES; i++)
+		tage->table[i][l->idx[i]].u--;
+	stats->tage_alloc_fail++;
+}
+
+static bool tage_resolve(void *self, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats)
+{
+	struct tage *tage = self;
+	struct lookup l;
+	lookup(tage, hist, pc, &l);
+
+	if (l.pred == taken)
+		stats->tage_correct++;
+	else
+		stats->tage_incorrect++;
+	stats->tage_provider[l.provider == TAGE_TABLES ? 0 : l.provider + 1]++;
+	tracei("[TAGE] %x %staken, provider %lu alt %lu predicted %d\n",
+		pc.u, taken ? "" : "not ", l.provider, l.alt, l.pred);
+
+	if (l.pred != taken)
+		allocate(tage, &l, taken, stats);
+
+	if (l.provider == TAGE_TABLES) {
+		uint8_t *b = &tage->base[l.base];
+		*b = taken ? (*b < 3 ? *b + 1 : 3) : (*b > 0 ? *b - 1 : 0);
+	} else {
+		struct tage_entry *e = &tage->table[l.provider][l.idx[l.provider]];
+		if (ctr_weak(e->ctr) && e->u == 0 && l.provider_pred != l.alt_pred)
+			tage->use_alt = ctr_update(tage->use_alt, l.alt_pred == taken, USE_ALT_MIN, USE_ALT_MAX);
+		if (l.provider_pred != l.alt_pred) {
+			if (l.provider_pred == taken)
+				e->u += e->u < U_MAX;
+			else
+				e->u -= e->u > 0;
+		}
+		/* Keep the alternate trained while the provider is fresh. */
+		if (e->u == 0) {
+			if (l.alt == TAGE_TABLES) {
+				uint8_t *b = &tage->base[l.base];
+				*b = taken ? (*b < 3 ? *b + 1 : 3) : (*b > 0 ? *b - 1 : 0);
+			} else {
+				struct tage_entry *a = &tage->table[l.alt][l.idx[l.alt]];
+				a->ctr = ctr_update(a->ctr, taken, CTR_MIN, CTR_MAX);
+			}
+		}
+		e->ctr = ctr_update(e->ctr, taken, CTR_MIN, CTR_MAX);
+	}
+
+	/* Age useful bits so that stale entries can be replaced. */
+	if (++tage->updates % U_RESET_PERIOD == 0) {
+		for (size_t i = 0; i < TAGE_TABLES; i++)
+			for (size_t j = 0; j < TAGE_TABLE_SIZE; j++)
+				tage->table[i][j].u >>= 1;
+	}
+
+	return tage_predict(tage, hist, pc) == BPRED_TAKEN;
+}
+
+static void *tage_create(void)
+{
+	struct tage *tage = malloc(sizeof(*tage));
+	if (tage)
+		tage_clear(tage);
+	return tage;
+}
+
+const struct bpred_ops tage_ops = {
+	.name = "tage",
+	.create = tage_create,
+	.clear = tage_clear,
+	.predict = tage_predict,
+	.spec_update = tage_spec_update,
+	.resolve = tage_resolve,
+};
@@ -0,0 +1,25 @@
+/* TAGE conditional branch predictor */
+#pragma once
+
+#include <stdint.h>
+
+#include "bpred.h"
+
+struct tage_entry {
+	int8_t ctr;
+	uint8_t u;
+	uint16_t tag;
+};
+
+/* Tables live once per simulation: decode reads them before retire
+ * writes them in the same cycle, like the double buffered state. */
+struct tage {
+	uint8_t base[TAGE_BASE_SIZE];
+	struct tage_entry table[TAGE_TABLES][TAGE_TABLE_SIZE];
+	/* Whether to trust a fresh entry or the alternate prediction. */
+	int8_t use_alt;
+	size_t updates;
+	uint32_t alloc_seed;
+};
+
+extern const struct bpred_ops tage_ops;
@@ -0,0 +1,103 @@
+#include "tournament.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "util.h"
+
+enum {
+	LOCAL_MAX = 7,
+	GLOBAL_MAX = 3,
+	CHOOSER_MAX = 3,
+};
+
+struct lookup {
+	size_t lh, l, g, c;
+	bool local_pred, global_pred, use_global;
+};
+
+static void lookup(const struct tournament *t, const struct bpred_hist *hist, word_u pc, struct lookup *l)
+{
+	const uint32_t p = pc.u >> 2;
+	l->lh = p & (TOURN_LOCAL_SIZE - 1);
+	l->l = t->local_hist[l->lh] & (TOURN_LOCAL_PHT_SIZE - 1);
+	l->g = (p ^ hist->recent) & (TOURN_GLOBAL_SIZE - 1);
+	l->c = p & (TOURN_CHOOSER_SIZE - 1);
+	l->local_pred = t->local[l->l] > LOCAL_MAX / 2;
+	l->global_pred = t->global[l->g] > GLOBAL_MAX / 2;
+	l->use_global = t->chooser[l->c] > CHOOSER_MAX / 2;
+}
+
+static uint8_t ctr_update(uint8_t ctr, bool up, uint8_t max)
+{
+	if (up)
+		return ctr < max ? ctr + 1 : ctr;
+	else
+		return ctr > 0 ? ctr - 1 : ctr;
+}
+
+static void tournament_clear(void *self)
+{
+	struct tournament *t = self;
+	memset(t, 0, sizeof(*t));
+	/* Weakly not taken, weakly local. */
+	memset(t->local, LOCAL_MAX / 2, sizeof(t->local));
+	memset(t->global, GLOBAL_MAX / 2, sizeof(t->global));
+	memset(t->chooser, CHOOSER_MAX / 2, sizeof(t->chooser));
+}
+
+static void *tournament_create(void)
+{
+	struct tournament *t = malloc(sizeof(*t));
+	if (t)
+		tournament_clear(t);
+	return t;
+}
+
+static enum bpred_dir tournament_predict(const void *self, const struct bpred_hist *hist, word_u pc)
+{
+	struct lookup l;
+	lookup(self, hist, pc, &l);
+	return (l.use_global ? l.global_pred : l.local_pred) ? BPRED_TAKEN : BPRED_NOT_TAKEN;
+}
+
+/* Local histories only change at retire, so in-flight instances of the
+ * same branch all see the same one. */
+static bool tournament_resolve(void *self, const struct bpred_hist *hist, word_u pc, bool taken, struct stats *stats)
+{
+	struct tournament *t = self;
+	struct lookup l;
+	lookup(t, hist, pc, &l);
+
+	if (l.use_global)
+		stats->tourn_chose_global++;
+	else
+		stats->tourn_chose_local++;
+	stats->tourn_local_correct += l.local_pred == taken;
+	stats->tourn_global_correct += l.global_pred == taken;
+	const bool pred = l.use_global ? l.global_pred : l.local_pred;
+	if (pred == taken)
+		stats->tourn_correct++;
+	else
+		stats->tourn_incorrect++;
+	tracei("[tournament] %x %staken, local %d global %d chose %s\n", pc.u, taken ? "" : "not ",
+		l.local_pred, l.global_pred, l.use_global ? "global" : "local");
+
+	if (l.local_pred != l.global_pred)
+		t->chooser[l.c] = ctr_update(t->chooser[l.c], l.global_pred == taken, CHOOSER_MAX);
+	t->local[l.l] = ctr_update(t->local[l.l], taken, LOCAL_MAX);
+	t->global[l.g] = ctr_update(t->global[l.g], taken, GLOBAL_MAX);
+	t->local_hist[l.lh] = (t->local_hist[l.lh] << 1) | taken;
+
+	return tournament_predict(t, hist, pc) == BPRED_TAKEN;
+}
+
+const struct bpred_ops tournament_ops = {
+	.name = "tournament",
+	.create = tournament_create,
+	.clear = tournament_clear,
+	.predict = tournament_predict,
+	.spec_update = bpred_hist_shift,
+	.resolve = tournament_resolve,
+};
@@ -0,0 +1,19 @@
+/* Tournament conditional branch predictor */
+#pragma once
+
+#include <stdint.h>
+
+#include "bpred.h"
+
+/* A local component (per-branch history into a table of 3 bit counters)
+ * and a global one (gshare), with a 2 bit chooser per PC picking
+ * between them, as in the Alpha 21264. */
+struct tournament {
+	uint16_t local_hist[TOURN_LOCAL_SIZE];
+	uint8_t local[TOURN_LOCAL_PHT_SIZE];
+	uint8_t global[TOURN_GLOBAL_SIZE];
+	/* 0, 1 for local, 2, 3 for global. */
+	uint8_t chooser[TOURN_CHOOSER_SIZE];
+};
+
+extern const struct bpred_ops tournament_ops;